@@ -0,0 +1,229 @@
+#include "analyzer.hpp"
+#include "btree.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+#include <thread>
+
+// Deeper than any real B-tree can get; hitting it means a page cycle in a corrupt file
+static constexpr uint32_t max_tree_depth = 64;
+
+double BTreeStats::average_fanout() const {
+    return interior_pages ? static_cast<double>(child_pointers) / static_cast<double>(interior_pages) : 0.0;
+}
+
+double BTreeStats::leaf_fill_percent(uint32_t usable_size) const {
+    if (leaf_pages == 0) return 0.0;
+    return 100.0 * static_cast<double>(leaf_used_bytes) / (static_cast<double>(leaf_pages) * usable_size);
+}
+
+StorageAnalyzer::StorageAnalyzer(const std::string& path, uint32_t page_size, uint32_t usable_size)
+    : pager(path), page_size(page_size), usable_size(usable_size), page_count(pager.size() / page_size) {}
+
+BTreeStats StorageAnalyzer::analyze(const SchemaObject& object) {
+    if (object.root_page <= 0 || static_cast<uint64_t>(object.root_page) > page_count) {
+        throw std::runtime_error("Root page out of range for " + object.name + ": " + std::to_string(object.root_page));
+    }
+
+    BTreeStats stats;
+    stats.name = object.name;
+    stats.type = object.type;
+    stats.root_page = static_cast<uint32_t>(object.root_page);
+
+    previous_leaf = 0;
+    std::vector<char> page_data(page_size);
+    walk(stats.root_page, 1, page_data, stats);
+    return stats;
+}
+
+void StorageAnalyzer::walk(uint32_t page_num, uint32_t level, std::vector<char>& page_data, BTreeStats& stats) {
+    if (page_num == 0 || page_num > page_count) {
+        throw std::runtime_error("Page number out of range: " + std::to_string(page_num));
+    }
+    if (level > max_tree_depth) {
+        throw std::runtime_error("B-tree " + stats.name + " is deeper than " + std::to_string(max_tree_depth) + " levels");
+    }
+
+    // One buffer serves the whole walk, so interior pages copy out their children before descending
+    pager.read_page(page_num, page_data);
+    size_t header_offset = (page_num == 1) ? 100 : 0;
+    PageType type = BTree::get_page_type(page_data, header_offset);
+    uint16_t cell_count = BTree::parse_cell_count(page_data, header_offset);
+
+    if (type == PageType::LeafTable || type == PageType::LeafIndex) {
+        bool is_index = (type == PageType::LeafIndex);
+        stats.leaf_pages++;
+        stats.entries += cell_count;
+        stats.depth = std::max(stats.depth, level);
+        if (previous_leaf != 0) {
+            stats.leaf_transitions++;
+            if (page_num != previous_leaf + 1) stats.out_of_order_leaves++;
+        }
+        previous_leaf = page_num;
+
+        count_free_space(page_data, header_offset, 8, cell_count, true, stats);
+        for (uint16_t i = 0; i < cell_count; ++i) {
+            count_overflow(page_data, BTree::parse_cell_pointer(page_data, header_offset + 8, i), is_index, stats);
+        }
+        return;
+    }
+
+    if (type != PageType::InteriorTable && type != PageType::InteriorIndex) {
+        throw std::runtime_error("Unexpected page type on page " + std::to_string(page_num) + " of " + stats.name);
+    }
+
+    bool is_index = (type == PageType::InteriorIndex);
+    stats.interior_pages++;
+    stats.child_pointers += static_cast<uint64_t>(cell_count) + 1;
+    count_free_space(page_data, header_offset, 12, cell_count, false, stats);
+
+    // Index keys live in interior cells too
+    std::vector<uint32_t> children;
+    children.reserve(static_cast<size_t>(cell_count) + 1);
+    for (uint16_t i = 0; i < cell_count; ++i) {
+        size_t cursor = BTree::parse_cell_pointer(page_data, header_offset + 12, i);
+        children.push_back(BTree::parse_interior_cell_left_child(std::span<const char>(page_data).subspan(cursor, 4)));
+        if (is_index) {
+            stats.entries++;
+            count_overflow(page_data, cursor + 4, true, stats);
+        }
+    }
+    children.push_back(BTree::get_right_most_pointer(page_data, header_offset));
+
+    for (uint32_t child : children) {
+        walk(child, level + 1, page_data, stats);
+    }
+}
+
+void StorageAnalyzer::count_free_space(std::span<const char> page_data, size_t header_offset, size_t header_size,
+                                       uint16_t cell_count, bool is_leaf, BTreeStats& stats) {
+    size_t pointer_array_end = header_offset + header_size + static_cast<size_t>(cell_count) * 2;
+    size_t content_start = BTree::parse_cell_content_start(page_data, header_offset);
+    uint64_t unallocated = (content_start > pointer_array_end) ? content_start - pointer_array_end : 0;
+
+    // Freeblocks: [2-byte next offset][2-byte size], chained in increasing offset order
+    uint64_t freeblocks = 0;
+    size_t freeblock = BTree::parse_first_freeblock(page_data, header_offset);
+    while (freeblock != 0) {
+        if (freeblock + 4 > usable_size) {
+            throw std::runtime_error("Freeblock past end of page");
+        }
+        freeblocks += Utils::parse_u16(page_data, freeblock + 2);
+        size_t next = Utils::parse_u16(page_data, freeblock);
+        if (next != 0 && next <= freeblock) {
+            throw std::runtime_error("Freeblock chain out of order");
+        }
+        freeblock = next;
+    }
+    uint64_t fragmented = BTree::parse_fragmented_bytes(page_data, header_offset);
+
+    stats.unallocated_bytes += unallocated;
+    stats.freeblock_bytes += freeblocks;
+    stats.fragmented_bytes += fragmented;
+    if (is_leaf) {
+        uint64_t free_bytes = std::min<uint64_t>(unallocated + freeblocks + fragmented, usable_size);
+        stats.leaf_used_bytes += usable_size - free_bytes;
+    }
+}
+
+void StorageAnalyzer::count_overflow(std::span<const char> page_data, size_t cursor, bool is_index, BTreeStats& stats) {
+    uint64_t payload_size = Utils::read_varint(page_data, cursor).first;
+    // Every overflow page but the last is full, so the chain length follows from the sizes alone
+    uint64_t local_size = BTree::local_payload_size(payload_size, usable_size, is_index);
+    uint64_t spilled = payload_size - local_size;
+    uint64_t per_page = usable_size - 4;
+    stats.overflow_pages += (spilled + per_page - 1) / per_page;
+}
+
+std::vector<BTreeStats> StorageAnalyzer::analyze_all(const std::string& path, uint32_t page_size, uint32_t usable_size,
+                                                     const std::vector<SchemaObject>& objects, unsigned threads) {
+    std::vector<BTreeStats> results(objects.size());
+    std::vector<std::exception_ptr> errors(objects.size());
+    std::atomic<size_t> next{0};
+
+    // One file handle per worker, opened up front so a failure surfaces here rather than in a thread
+    size_t worker_count = std::clamp<size_t>(threads, 1, std::max<size_t>(objects.size(), 1));
+    std::vector<StorageAnalyzer> analyzers;
+    analyzers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) analyzers.emplace_back(path, page_size, usable_size);
+
+    // Workers pull the next unclaimed object, so one large table doesn't hold up the small ones
+    auto worker = [&](StorageAnalyzer& analyzer) {
+        for (size_t i = next++; i < objects.size(); i = next++) {
+            try {
+                results[i] = analyzer.analyze(objects[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < worker_count; ++i) workers.emplace_back(worker, std::ref(analyzers[i]));
+    worker(analyzers[0]);
+    for (auto& t : workers) t.join();
+
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    return results;
+}
+
+static void append_json_string(std::string& out, const std::string& value) {
+    out += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+std::string StorageAnalyzer::format_json(const BTreeStats& stats, uint32_t usable_size) {
+    std::string out = "{\"name\":";
+    append_json_string(out, stats.name);
+    out += ",\"type\":";
+    append_json_string(out, stats.type);
+
+    auto field = [&out](const char* key, uint64_t value) {
+        out += ",\"";
+        out += key;
+        out += "\":";
+        out += std::to_string(value);
+    };
+    auto ratio = [&out](const char* key, double value) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.2f", value);
+        out += ",\"";
+        out += key;
+        out += "\":";
+        out += buffer;
+    };
+
+    field("root_page", stats.root_page);
+    field("depth", stats.depth);
+    field("interior_pages", stats.interior_pages);
+    field("leaf_pages", stats.leaf_pages);
+    field("overflow_pages", stats.overflow_pages);
+    field("entries", stats.entries);
+    ratio("average_fanout", stats.average_fanout());
+    ratio("leaf_fill_percent", stats.leaf_fill_percent(usable_size));
+    field("unallocated_bytes", stats.unallocated_bytes);
+    field("freeblock_bytes", stats.freeblock_bytes);
+    field("fragmented_bytes", stats.fragmented_bytes);
+    field("leaf_transitions", stats.leaf_transitions);
+    field("out_of_order_leaves", stats.out_of_order_leaves);
+    out += '}';
+    return out;
+}
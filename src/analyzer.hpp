@@ -0,0 +1,62 @@
+#pragma once
+#include "pager.hpp"
+#include "schema.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Physical shape of one table or index B-tree, gathered by visiting every page of it
+struct BTreeStats {
+    std::string name;
+    std::string type;
+    uint32_t root_page = 0;
+
+    uint32_t depth = 0;            // Levels from root to leaves; a lone root leaf is depth 1
+    uint64_t interior_pages = 0;
+    uint64_t leaf_pages = 0;
+    uint64_t overflow_pages = 0;
+    uint64_t entries = 0;          // Rows for tables; keys for indexes (interior keys included)
+    uint64_t child_pointers = 0;   // Sum of children over interior pages, for the average fanout
+
+    // Byte accounting over all B-tree pages of the object; leaf_used_bytes is leaves only
+    uint64_t leaf_used_bytes = 0;
+    uint64_t unallocated_bytes = 0; // Gap between the cell pointer array and the cell content area
+    uint64_t freeblock_bytes = 0;
+    uint64_t fragmented_bytes = 0;
+
+    // Consecutive leaves in key order, and how many of those steps are not to the next page in
+    // the file (each one breaks a sequential read)
+    uint64_t leaf_transitions = 0;
+    uint64_t out_of_order_leaves = 0;
+
+    double average_fanout() const;
+    double leaf_fill_percent(uint32_t usable_size) const;
+};
+
+// Walks B-trees page by page. Each analyzer has its own file handle, so separate instances can
+// run on separate threads
+class StorageAnalyzer {
+public:
+    StorageAnalyzer(const std::string& path, uint32_t page_size, uint32_t usable_size);
+
+    BTreeStats analyze(const SchemaObject& object);
+
+    // Analyzes all objects on up to `threads` workers; results are in the order of `objects`
+    static std::vector<BTreeStats> analyze_all(const std::string& path, uint32_t page_size, uint32_t usable_size,
+                                               const std::vector<SchemaObject>& objects, unsigned threads);
+
+    // One JSON object per B-tree, no trailing newline
+    static std::string format_json(const BTreeStats& stats, uint32_t usable_size);
+
+private:
+    Pager pager;
+    uint32_t page_size;
+    uint32_t usable_size;
+    uint64_t page_count;
+    uint32_t previous_leaf = 0;
+
+    void walk(uint32_t page_num, uint32_t level, std::vector<char>& page_data, BTreeStats& stats);
+    void count_free_space(std::span<const char> page_data, size_t header_offset, size_t header_size, uint16_t cell_count,
+                          bool is_leaf, BTreeStats& stats);
+    void count_overflow(std::span<const char> page_data, size_t cursor, bool is_index, BTreeStats& stats);
+};
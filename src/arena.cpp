@@ -0,0 +1,25 @@
+#include "arena.hpp"
+
+// The pool serves the small scratch allocations. Page and overflow buffers are larger and go
+// straight to the upstream at their exact size, so a pool chunk never rounds a 64 KiB page up
+// to a megabyte and the limit and peak follow what the query really holds
+static constexpr size_t largest_pooled_block = 1024;
+static constexpr size_t max_blocks_per_chunk = 16;
+
+void* QueryArena::LimitedResource::do_allocate(size_t bytes, size_t alignment) {
+    if (limit_bytes != 0 && in_use + bytes > limit_bytes) {
+        throw QueryMemoryLimitExceeded(limit_bytes);
+    }
+    void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    in_use += bytes;
+    if (in_use > peak) peak = in_use;
+    return p;
+}
+
+void QueryArena::LimitedResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    in_use -= bytes;
+}
+
+QueryArena::QueryArena(size_t limit_bytes)
+    : upstream(limit_bytes), pool(std::pmr::pool_options{max_blocks_per_chunk, largest_pooled_block}, &upstream) {}
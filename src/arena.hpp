@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <streambuf>
+
+// Thrown when a query asks for more memory than its arena allows
+class QueryMemoryLimitExceeded : public std::bad_alloc {
+private:
+    std::string message;
+
+public:
+    explicit QueryMemoryLimitExceeded(size_t limit_bytes)
+        : message("query exceeded memory limit of " + std::to_string(limit_bytes) + " bytes") {}
+    const char* what() const noexcept override { return message.c_str(); }
+};
+
+// Per-query memory: a pool that recycles small scratch vectors between rows, drawing chunks
+// (and page-sized buffers directly) from an upstream that enforces the limit and tracks the
+// high-water mark.
+// Everything is returned to the system at once when the arena goes out of scope.
+class QueryArena {
+private:
+    class LimitedResource : public std::pmr::memory_resource {
+    public:
+        size_t limit_bytes; // 0 means unlimited
+        size_t in_use = 0;
+        size_t peak = 0;
+
+        explicit LimitedResource(size_t limit) : limit_bytes(limit) {}
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    LimitedResource upstream;
+    std::pmr::unsynchronized_pool_resource pool;
+
+public:
+    explicit QueryArena(size_t limit_bytes);
+
+    std::pmr::memory_resource* resource() { return &pool; }
+    size_t peak_bytes() const { return upstream.peak; }
+};
+
+// Stream buffer whose text lives in a query arena: the result counts against the query's limit
+// and is simply dropped if the query fails partway
+class ArenaOutputBuffer : public std::streambuf {
+private:
+    std::pmr::string text;
+
+public:
+    explicit ArenaOutputBuffer(std::pmr::memory_resource* resource) : text(resource) {}
+    const std::pmr::string& str() const { return text; }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) text.push_back(traits_type::to_char_type(ch));
+        return traits_type::not_eof(ch);
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        text.append(s, static_cast<size_t>(n));
+        return n;
+    }
+};
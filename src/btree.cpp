@@ -1,7 +1,7 @@
 #include "btree.hpp"
 #include "utils.hpp"
 
-PageType BTree::get_page_type(const std::vector<char>& page_data, size_t header_offset) {
+PageType BTree::get_page_type(std::span<const char> page_data, size_t header_offset) {
     if (header_offset >= page_data.size()) return PageType::Unknown;
     uint8_t flag = static_cast<uint8_t>(page_data[header_offset]);
     switch (flag) {
@@ -13,17 +13,49 @@ PageType BTree::get_page_type(const std::vector<char>& page_data, size_t header_
     }
 }
 
-uint16_t BTree::parse_cell_count(const std::vector<char>& page_data, size_t header_offset) {
+uint16_t BTree::parse_cell_count(std::span<const char> page_data, size_t header_offset) {
     return Utils::parse_u16(page_data, header_offset + 3);
 }
 
-uint32_t BTree::get_right_most_pointer(const std::vector<char>& page_data, size_t header_offset) {
+uint32_t BTree::get_right_most_pointer(std::span<const char> page_data, size_t header_offset) {
     // Right-most pointer is at offset 8 in header (4 bytes)
     return Utils::parse_u32(page_data, header_offset + 8);
 }
 
-std::vector<uint16_t> BTree::parse_cell_pointers(const std::vector<char>& page_data, size_t array_start_offset, uint16_t cell_count) {
+uint16_t BTree::parse_first_freeblock(std::span<const char> page_data, size_t header_offset) {
+    return Utils::parse_u16(page_data, header_offset + 1);
+}
+
+uint32_t BTree::parse_cell_content_start(std::span<const char> page_data, size_t header_offset) {
+    uint16_t start = Utils::parse_u16(page_data, header_offset + 5);
+    return (start == 0) ? 65536 : start;
+}
+
+uint8_t BTree::parse_fragmented_bytes(std::span<const char> page_data, size_t header_offset) {
+    if (header_offset + 7 >= page_data.size()) {
+        throw std::out_of_range("Buffer overflow reading fragmented byte count");
+    }
+    return static_cast<uint8_t>(page_data[header_offset + 7]);
+}
+
+uint64_t BTree::local_payload_size(uint64_t payload_size, uint32_t usable_size, bool is_index) {
+    // Local payload limits from the file format spec, all derived from the usable size
+    uint64_t u = usable_size;
+    uint64_t max_local = is_index ? ((u - 12) * 64 / 255) - 23 : u - 35;
+    if (payload_size <= max_local) return payload_size;
+
+    uint64_t min_local = ((u - 12) * 32 / 255) - 23;
+    uint64_t k = min_local + ((payload_size - min_local) % (u - 4));
+    return (k <= max_local) ? k : min_local;
+}
+
+uint16_t BTree::parse_cell_pointer(std::span<const char> page_data, size_t array_start_offset, uint16_t i) {
+    return Utils::parse_u16(page_data, array_start_offset + (static_cast<size_t>(i) * 2));
+}
+
+std::vector<uint16_t> BTree::parse_cell_pointers(std::span<const char> page_data, size_t array_start_offset, uint16_t cell_count) {
     std::vector<uint16_t> pointers;
+    pointers.reserve(cell_count);
     for (int i = 0; i < cell_count; ++i) {
         size_t ptr_offset = array_start_offset + (i * 2);
         pointers.push_back(Utils::parse_u16(page_data, ptr_offset));
@@ -31,7 +63,7 @@ std::vector<uint16_t> BTree::parse_cell_pointers(const std::vector<char>& page_d
     return pointers;
 }
 
-uint32_t BTree::parse_interior_cell_left_child(const std::vector<char>& cell_data) {
+uint32_t BTree::parse_interior_cell_left_child(std::span<const char> cell_data) {
     // Interior Table/Index Cell starts with 4-byte page number
     return Utils::parse_u32(cell_data, 0);
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
+#include <span>
 #include <cstdint>
+#include <cstddef>
 
 enum class PageType {
     InteriorIndex = 0x02,
@@ -12,13 +14,25 @@ enum class PageType {
 
 class BTree {
 public:
-    static PageType get_page_type(const std::vector<char>& page_data, size_t header_offset);
-    static uint16_t parse_cell_count(const std::vector<char>& page_data, size_t header_offset);
-    static uint32_t get_right_most_pointer(const std::vector<char>& page_data, size_t header_offset);
+    static PageType get_page_type(std::span<const char> page_data, size_t header_offset);
+    static uint16_t parse_cell_count(std::span<const char> page_data, size_t header_offset);
+    static uint32_t get_right_most_pointer(std::span<const char> page_data, size_t header_offset);
+
+    // Free-space bookkeeping from the page header: freeblock chain head, start of the cell
+    // content area (0 means 65536), and the count of fragmented bytes
+    static uint16_t parse_first_freeblock(std::span<const char> page_data, size_t header_offset);
+    static uint32_t parse_cell_content_start(std::span<const char> page_data, size_t header_offset);
+    static uint8_t parse_fragmented_bytes(std::span<const char> page_data, size_t header_offset);
+
+    // Bytes of a cell payload stored on the B-tree page itself; the rest spills to overflow pages
+    static uint64_t local_payload_size(uint64_t payload_size, uint32_t usable_size, bool is_index);
     
+    // Reads entry `i` of the cell pointer array without materializing the whole array
+    static uint16_t parse_cell_pointer(std::span<const char> page_data, size_t array_start_offset, uint16_t i);
+
     // Updated: takes absolute offset to start of pointer array
-    static std::vector<uint16_t> parse_cell_pointers(const std::vector<char>& page_data, size_t array_start_offset, uint16_t cell_count);
+    static std::vector<uint16_t> parse_cell_pointers(std::span<const char> page_data, size_t array_start_offset, uint16_t cell_count);
     
     // Returns the left child page number from an interior cell
-    static uint32_t parse_interior_cell_left_child(const std::vector<char>& cell_data);
+    static uint32_t parse_interior_cell_left_child(std::span<const char> cell_data);
 };
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "columnar.hpp"
+#include <charconv>
+#include <cstdlib>
+
+// Parses `text` only if it is the exact string the row store would print for the integer
+static bool parse_canonical_int(const std::string& text, int64_t& value) {
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && end == text.data() + text.size() && std::to_string(value) == text;
+}
+
+void ColumnarTable::append_row(int64_t rowid, const std::vector<Value>& values) {
+    size_t row = rowids.size();
+    rowids.push_back(rowid);
+
+    // Columns first seen on this row were NULL for every earlier row
+    while (columns.size() < values.size()) {
+        ColumnarColumn column;
+        column.null_bits.assign((row + 63) / 64, ~uint64_t{0});
+        columns.push_back(std::move(column));
+    }
+
+    // Rows written before an ALTER TABLE ADD COLUMN carry fewer values; the rest are NULL
+    static const Value null_value;
+    for (size_t col = 0; col < columns.size(); ++col) {
+        push_value(columns[col], row, col < values.size() ? values[col] : null_value);
+    }
+}
+
+void ColumnarTable::push_value(ColumnarColumn& column, size_t row, const Value& value) {
+    if (row % 64 == 0) column.null_bits.push_back(0);
+
+    ColumnKind value_kind = ColumnKind::Null;
+    switch (value.type) {
+        case ValueType::Null: value_kind = ColumnKind::Null; break;
+        case ValueType::Integer: value_kind = ColumnKind::Integer; break;
+        case ValueType::Real: value_kind = ColumnKind::Real; break;
+        case ValueType::Text: value_kind = ColumnKind::Text; break;
+        case ValueType::Blob: value_kind = ColumnKind::Mixed; break; // Blobs display as ""
+    }
+
+    if (value_kind != ColumnKind::Null && value_kind != column.kind) {
+        if (column.kind == ColumnKind::Null) {
+            // First non-NULL value: earlier rows become placeholders behind the null bitmap
+            column.kind = value_kind;
+            if (value_kind == ColumnKind::Integer) column.integers.resize(row);
+            else if (value_kind == ColumnKind::Real) column.reals.resize(row);
+            else column.codes.resize(row);
+        } else if (column.kind != ColumnKind::Mixed) {
+            promote_to_mixed(column);
+        }
+    }
+
+    uint64_t bit = uint64_t{1} << (row % 64);
+    if (value_kind == ColumnKind::Null) column.null_bits[row / 64] |= bit;
+    else column.null_bits[row / 64] &= ~bit;
+
+    switch (column.kind) {
+        case ColumnKind::Null:
+            break;
+        case ColumnKind::Integer:
+            column.integers.push_back(value.integer);
+            break;
+        case ColumnKind::Real:
+            column.reals.push_back(value.real);
+            break;
+        case ColumnKind::Text:
+            column.codes.push_back(value_kind == ColumnKind::Null ? 0 : intern(column, std::string(value.bytes)));
+            break;
+        case ColumnKind::Mixed: {
+            std::string text;
+            if (value.type == ValueType::Integer) text = std::to_string(value.integer);
+            else if (value.type == ValueType::Real) text = Record::format_real(value.real);
+            else if (value.type == ValueType::Text) text = std::string(value.bytes);
+            column.codes.push_back(value_kind == ColumnKind::Null ? 0 : intern(column, text));
+            break;
+        }
+    }
+}
+
+void ColumnarTable::promote_to_mixed(ColumnarColumn& column) {
+    size_t rows = column.kind == ColumnKind::Integer ? column.integers.size()
+                : column.kind == ColumnKind::Real ? column.reals.size()
+                : column.codes.size();
+
+    if (column.kind == ColumnKind::Text) {
+        // Text dictionaries already hold display strings
+        column.kind = ColumnKind::Mixed;
+        return;
+    }
+
+    std::vector<uint32_t> codes(rows, 0);
+    for (size_t row = 0; row < rows; ++row) {
+        if (column.is_null(row)) continue;
+        std::string text = column.kind == ColumnKind::Integer ? std::to_string(column.integers[row])
+                                                              : Record::format_real(column.reals[row]);
+        codes[row] = intern(column, text);
+    }
+    column.codes = std::move(codes);
+    column.integers = {};
+    column.reals = {};
+    column.kind = ColumnKind::Mixed;
+}
+
+uint32_t ColumnarTable::intern(ColumnarColumn& column, const std::string& text) {
+    auto [it, inserted] = column.dictionary_index.try_emplace(text, static_cast<uint32_t>(column.dictionary.size()));
+    if (inserted) column.dictionary.push_back(text);
+    return it->second;
+}
+
+std::pmr::vector<uint32_t> ColumnarTable::select_equal(size_t col, const std::string& value, std::pmr::memory_resource* memory) const {
+    std::pmr::vector<uint32_t> rows(memory);
+    size_t n = row_count();
+
+    // NULLs (and columns never seen) display as "", so they match only an empty literal
+    bool match_nulls = value.empty();
+    if (col >= columns.size()) {
+        if (match_nulls) for (size_t row = 0; row < n; ++row) rows.push_back(static_cast<uint32_t>(row));
+        return rows;
+    }
+
+    const ColumnarColumn& column = columns[col];
+    switch (column.kind) {
+        case ColumnKind::Null:
+            if (match_nulls) for (size_t row = 0; row < n; ++row) rows.push_back(static_cast<uint32_t>(row));
+            break;
+        case ColumnKind::Integer: {
+            int64_t target;
+            bool comparable = parse_canonical_int(value, target);
+            for (size_t row = 0; row < n; ++row) {
+                bool is_null = column.is_null(row);
+                if ((is_null && match_nulls) || (!is_null && comparable && column.integers[row] == target)) {
+                    rows.push_back(static_cast<uint32_t>(row));
+                }
+            }
+            break;
+        }
+        case ColumnKind::Real: {
+            double target = std::strtod(value.c_str(), nullptr);
+            bool comparable = !value.empty() && Record::format_real(target) == value;
+            for (size_t row = 0; row < n; ++row) {
+                bool is_null = column.is_null(row);
+                if ((is_null && match_nulls) || (!is_null && comparable && column.reals[row] == target)) {
+                    rows.push_back(static_cast<uint32_t>(row));
+                }
+            }
+            break;
+        }
+        case ColumnKind::Text:
+        case ColumnKind::Mixed: {
+            // One hash lookup, then integer compares over the code array
+            auto it = column.dictionary_index.find(value);
+            bool comparable = it != column.dictionary_index.end();
+            uint32_t target = comparable ? it->second : 0;
+            for (size_t row = 0; row < n; ++row) {
+                bool is_null = column.is_null(row);
+                if ((is_null && match_nulls) || (!is_null && comparable && column.codes[row] == target)) {
+                    rows.push_back(static_cast<uint32_t>(row));
+                }
+            }
+            break;
+        }
+    }
+    return rows;
+}
+
+std::pmr::vector<uint32_t> ColumnarTable::select_rowid(const std::string& value, std::pmr::memory_resource* memory) const {
+    std::pmr::vector<uint32_t> rows(memory);
+    int64_t target;
+    if (!parse_canonical_int(value, target)) return rows;
+    for (size_t row = 0; row < rowids.size(); ++row) {
+        if (rowids[row] == target) rows.push_back(static_cast<uint32_t>(row));
+    }
+    return rows;
+}
+
+std::string_view ColumnarTable::format(size_t col, size_t row, NumberBuffer& scratch) const {
+    if (col >= columns.size()) return {};
+    const ColumnarColumn& column = columns[col];
+    if (column.kind == ColumnKind::Null || column.is_null(row)) return {};
+    switch (column.kind) {
+        case ColumnKind::Integer: {
+            auto [end, ec] = std::to_chars(scratch.data(), scratch.data() + scratch.size(), column.integers[row]);
+            return std::string_view(scratch.data(), end - scratch.data());
+        }
+        case ColumnKind::Real: return Record::format_real(column.reals[row], scratch);
+        default: return column.dictionary[column.codes[row]];
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "record.hpp"
+#include "result_cache.hpp"
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class ColumnKind {
+    Null,    // Every value so far is NULL
+    Integer,
+    Real,
+    Text,    // Dictionary-encoded
+    Mixed    // More than one storage class; dictionary of display strings
+};
+
+struct ColumnarColumn {
+    ColumnKind kind = ColumnKind::Null;
+    std::vector<uint64_t> null_bits; // Bit i set means row i is NULL
+
+    // Exactly one of these is populated (by row position) depending on `kind`
+    std::vector<int64_t> integers;
+    std::vector<double> reals;
+    std::vector<uint32_t> codes;
+    std::vector<std::string> dictionary;
+    std::unordered_map<std::string, uint32_t> dictionary_index;
+
+    bool is_null(size_t row) const { return (null_bits[row / 64] >> (row % 64)) & 1; }
+};
+
+// A table decoded once into typed, contiguous column arrays. Valid while `stamp` matches the file
+class ColumnarTable {
+private:
+    std::vector<int64_t> rowids;
+    std::vector<ColumnarColumn> columns;
+
+    void push_value(ColumnarColumn& column, size_t row, const Value& value);
+    void promote_to_mixed(ColumnarColumn& column);
+    static uint32_t intern(ColumnarColumn& column, const std::string& text);
+
+public:
+    CacheStamp stamp;
+
+    void append_row(int64_t rowid, const std::vector<Value>& values);
+    size_t row_count() const { return rowids.size(); }
+    int64_t rowid(size_t row) const { return rowids[row]; }
+
+    // Row positions whose display value equals `value` (same semantics as the row-store filter),
+    // allocated from the running query's `memory`
+    std::pmr::vector<uint32_t> select_equal(size_t col, const std::string& value, std::pmr::memory_resource* memory) const;
+    std::pmr::vector<uint32_t> select_rowid(const std::string& value, std::pmr::memory_resource* memory) const;
+
+    // Display text; numbers are formatted into `scratch`, text views the dictionary
+    std::string_view format(size_t col, size_t row, NumberBuffer& scratch) const;
+};
@@ -6,31 +6,108 @@
 #include "record.hpp"
 #include <iostream>
 #include <algorithm>
+#include <stdexcept>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <charconv>
+#include <map>
+#include <thread>
+
+// SQLite's planner assumes an equality on an unanalyzed index matches about 10 rows
+static constexpr double default_eq_rows = 10.0;
 
 Database::Database(const std::string& filename) : pager(filename) {
     std::vector<char> header = pager.read_bytes(0, 100);
-    page_size = Utils::parse_u16(header, 16);
+
+    // Offset 16: page size. 65536 doesn't fit in a u16, so the format stores it as 1
+    uint32_t raw_page_size = Utils::parse_u16(header, 16);
+    page_size = (raw_page_size == 1) ? 65536 : raw_page_size;
+    if (page_size < 512 || page_size > 65536 || (page_size & (page_size - 1)) != 0) {
+        throw std::runtime_error("Invalid page size: " + std::to_string(raw_page_size));
+    }
+
+    // Offset 20: bytes reserved at the end of each page (e.g. for encryption extensions)
+    uint8_t reserved = static_cast<uint8_t>(header[20]);
+    usable_size = page_size - reserved;
+    if (usable_size < 480) {
+        throw std::runtime_error("Invalid reserved space: " + std::to_string(reserved));
+    }
+
+    page_count = pager.size() / page_size;
+}
+
+void Database::read_page(uint32_t page_num, std::pmr::vector<char>& out) {
+    if (page_num == 0 || page_num > page_count) {
+        throw std::runtime_error("Page number out of range: " + std::to_string(page_num));
+    }
+    out.resize(page_size);
+    pager.read_page(page_num, out);
+}
+
+std::span<const char> Database::read_payload(std::span<const char> page_data, size_t cursor, uint64_t payload_size, bool is_index,
+                                             std::pmr::vector<char>& overflow_buffer) {
+    uint64_t local_size = BTree::local_payload_size(payload_size, usable_size, is_index);
+
+    if (cursor + local_size > page_data.size()) {
+        throw std::runtime_error("Cell payload exceeds page bounds");
+    }
+    if (local_size == payload_size) return page_data.subspan(cursor, local_size);
+
+    // Overflow chain: [4-byte next page][usable_size - 4 bytes of content]
+    overflow_buffer.assign(page_data.begin() + cursor, page_data.begin() + cursor + local_size);
+    overflow_buffer.reserve(payload_size);
+    std::pmr::vector<char> overflow_data(memory);
+    uint32_t overflow_page = Utils::parse_u32(page_data, cursor + local_size);
+    while (overflow_page != 0 && overflow_buffer.size() < payload_size) {
+        read_page(overflow_page, overflow_data);
+        uint64_t chunk = std::min<uint64_t>(payload_size - overflow_buffer.size(), usable_size - 4);
+        overflow_buffer.insert(overflow_buffer.end(), overflow_data.begin() + 4, overflow_data.begin() + 4 + chunk);
+        overflow_page = Utils::parse_u32(overflow_data, 0);
+    }
+    if (overflow_buffer.size() != payload_size) {
+        throw std::runtime_error("Truncated overflow chain");
+    }
+    return overflow_buffer;
 }
 
 void Database::print_db_info() {
     std::cout << "database page size: " << page_size << std::endl;
-    std::vector<char> page_1_header = pager.read_bytes(100, 8);
-    uint16_t table_count = BTree::parse_cell_count(page_1_header, 0);
-    std::cout << "number of tables: " << table_count << std::endl;
+    std::cout << "number of tables: " << read_schema().size() << std::endl;
+}
+
+std::vector<SchemaObject> Database::read_schema() {
+    std::vector<SchemaObject> schema;
+    for_each_row(1, [&](int64_t, std::span<const char> payload) {
+        schema.push_back(Schema::parse_entry(payload));
+    });
+    return schema;
 }
 
 void Database::list_tables() {
-    std::vector<char> page_1 = pager.read_bytes(0, page_size);
-    auto tables = Schema::get_table_names(page_1);
+    auto tables = Schema::get_table_names(read_schema());
     for (size_t i = 0; i < tables.size(); ++i) {
         std::cout << tables[i] << (i == tables.size() - 1 ? "" : " ");
     }
     std::cout << std::endl;
 }
 
-std::optional<std::vector<char>> Database::get_row_by_id(uint32_t page_num, int64_t row_id) {
-    size_t offset = (static_cast<size_t>(page_num) - 1) * page_size;
-    std::vector<char> page_data = pager.read_bytes(offset, page_size);
+void Database::analyze_storage() {
+    // sqlite_schema has no row of its own; its B-tree is rooted at page 1
+    std::vector<SchemaObject> objects{{"table", "sqlite_schema", "sqlite_schema", 1, ""}};
+    auto catalog = Schema::get_btree_objects(read_schema());
+    objects.insert(objects.end(), catalog.begin(), catalog.end());
+
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    for (const auto& stats : StorageAnalyzer::analyze_all(pager.path(), page_size, usable_size, objects, threads)) {
+        std::cout << StorageAnalyzer::format_json(stats, usable_size) << '\n';
+    }
+    std::cout << std::flush;
+}
+
+bool Database::get_row_by_id(uint32_t page_num, int64_t row_id, std::pmr::vector<char>& out) {
+    std::pmr::vector<char> page_data(memory);
+    read_page(page_num, page_data);
     size_t header_offset = (page_num == 1) ? 100 : 0;
     
     PageType type = BTree::get_page_type(page_data, header_offset);
@@ -38,127 +115,153 @@ std::optional<std::vector<char>> Database::get_row_by_id(uint32_t page_num, int6
 
     if (type == PageType::LeafTable) {
         size_t ptr_array_start = header_offset + 8;
-        auto pointers = BTree::parse_cell_pointers(page_data, ptr_array_start, cell_count);
         
         // Optimization: Binary Search could be used here, keeping linear for now
-        for (uint16_t ptr : pointers) {
-            size_t cursor = ptr;
+        for (uint16_t i = 0; i < cell_count; ++i) {
+            size_t cursor = BTree::parse_cell_pointer(page_data, ptr_array_start, i);
             auto [payload_size, s1] = Utils::read_varint(page_data, cursor);
             cursor += s1;
             auto [rid, s2] = Utils::read_varint(page_data, cursor);
             cursor += s2;
             
             if (static_cast<int64_t>(rid) == row_id) {
-                return std::vector<char>(page_data.begin() + cursor, 
-                                         page_data.begin() + cursor + payload_size);
+                auto payload = read_payload(page_data, cursor, payload_size, false, out);
+                // The payload may still point into this frame's page buffer
+                if (payload.data() != out.data()) out.assign(payload.begin(), payload.end());
+                return true;
             }
         }
     } else if (type == PageType::InteriorTable) {
         size_t ptr_array_start = header_offset + 12;
-        auto pointers = BTree::parse_cell_pointers(page_data, ptr_array_start, cell_count);
         
-        for (uint16_t ptr : pointers) {
-            size_t cursor = ptr;
+        for (uint16_t i = 0; i < cell_count; ++i) {
+            size_t cursor = BTree::parse_cell_pointer(page_data, ptr_array_start, i);
             // Interior Table: [4-byte ptr] [varint key]
             uint32_t child_page = Utils::parse_u32(page_data, cursor);
             cursor += 4;
             auto [key, s] = Utils::read_varint(page_data, cursor);
             
             if (row_id <= static_cast<int64_t>(key)) {
-                return get_row_by_id(child_page, row_id);
+                return get_row_by_id(child_page, row_id, out);
             }
         }
         // Right-most pointer
         uint32_t right_most = BTree::get_right_most_pointer(page_data, header_offset);
-        return get_row_by_id(right_most, row_id);
+        return get_row_by_id(right_most, row_id, out);
     }
-    return std::nullopt;
+    return false;
 }
 
-void Database::scan_index(uint32_t page_num, uint32_t table_root_page, const QueryContext& ctx, int& row_count) {
-    size_t offset = (static_cast<size_t>(page_num) - 1) * page_size;
-    std::vector<char> page_data = pager.read_bytes(offset, page_size);
+void Database::emit_row(int64_t row_id, std::span<const char> row_payload, const QueryContext& ctx, uint64_t& row_count) {
+    if (ctx.count_mode) {
+        row_count++;
+        return;
+    }
+    // Build the whole line in one pooled buffer and hand it to the stream once
+    std::pmr::string line(memory);
+    NumberBuffer scratch;
+    for (size_t i = 0; i < ctx.targets.size(); ++i) {
+        if (ctx.targets[i].is_primary_key) {
+            auto [end, ec] = std::to_chars(scratch.data(), scratch.data() + scratch.size(), row_id);
+            line.append(scratch.data(), end);
+        } else {
+            line += ctx.decoder->text(ctx.targets[i].slot, row_payload, scratch);
+        }
+        if (i != ctx.targets.size() - 1) line += '|';
+    }
+    line += '\n';
+    ctx.out->write(line.data(), static_cast<std::streamsize>(line.size()));
+}
+
+void Database::emit_index_match(std::span<const char> index_payload, uint32_t table_root_page, const QueryContext& ctx, uint64_t& row_count) {
+    // Index Record: [key columns..., RowID]
+    if (ctx.covering) {
+        if (ctx.count_mode) {
+            row_count++;
+            return;
+        }
+        std::pmr::string line(memory);
+        NumberBuffer scratch;
+        for (size_t i = 0; i < ctx.index_positions.size(); ++i) {
+            line += Record::column_text(index_payload, ctx.index_positions[i], scratch);
+            if (i != ctx.index_positions.size() - 1) line += '|';
+        }
+        line += '\n';
+        ctx.out->write(line.data(), static_cast<std::streamsize>(line.size()));
+        return;
+    }
+
+    int64_t row_id = Record::parse_int_column(index_payload, ctx.index_rowid_col);
+    std::pmr::vector<char> row_payload(memory);
+    if (get_row_by_id(table_root_page, row_id, row_payload)) {
+        ctx.decoder->bind(row_payload);
+        emit_row(row_id, row_payload, ctx, row_count);
+    }
+}
+
+void Database::scan_index(uint32_t page_num, uint32_t table_root_page, const KeyProbe& probe, const QueryContext& ctx, uint64_t& row_count) {
+    std::pmr::vector<char> page_data(memory);
+    read_page(page_num, page_data);
     size_t header_offset = 0; // Index pages never on page 1
     
     PageType type = BTree::get_page_type(page_data, header_offset);
     uint16_t cell_count = BTree::parse_cell_count(page_data, header_offset);
+    std::pmr::vector<char> overflow_buffer(memory);
+    NumberBuffer scratch;
+
+    // Keys equal to the probe can still display differently (9 vs 9.0), so matches are confirmed
+    // against the literal the same way scan_table filters
+    auto matches = [&](std::span<const char> payload) {
+        return Record::column_text(payload, 0, scratch) == ctx.where_value;
+    };
 
     if (type == PageType::LeafIndex) { // 0x0A
         size_t ptr_array_start = header_offset + 8;
-        auto pointers = BTree::parse_cell_pointers(page_data, ptr_array_start, cell_count);
         
-        for (uint16_t ptr : pointers) {
-            size_t cursor = ptr;
+        for (uint16_t i = 0; i < cell_count; ++i) {
+            size_t cursor = BTree::parse_cell_pointer(page_data, ptr_array_start, i);
             auto [payload_size, s1] = Utils::read_varint(page_data, cursor);
             cursor += s1;
-            std::vector<char> payload(page_data.begin() + cursor, page_data.begin() + cursor + payload_size);
+            auto payload = read_payload(page_data, cursor, payload_size, true, overflow_buffer);
             
             // Index Record: [IndexedColumnValue, RowID]
-            std::string val = Record::parse_column_to_string(payload, 0);
-            
-            if (val == ctx.where_value) {
-                // Found match! Get RowID
-                int64_t row_id = Record::parse_int_column(payload, 1); // RowID is usually 2nd col
-                
-                auto row_payload_opt = get_row_by_id(table_root_page, row_id);
-                if (row_payload_opt) {
-                    auto& row_payload = *row_payload_opt;
-                    
-                    if (ctx.count_mode) {
-                        row_count++;
-                    } else {
-                        for (size_t i = 0; i < ctx.targets.size(); ++i) {
-                            std::string col_val;
-                            if (ctx.targets[i].is_primary_key) {
-                                col_val = std::to_string(row_id);
-                            } else {
-                                col_val = Record::parse_column_to_string(row_payload, ctx.targets[i].index);
-                            }
-                            std::cout << col_val << (i == ctx.targets.size() - 1 ? "" : "|");
-                        }
-                        std::cout << std::endl;
-                    }
-                }
-            } else if (val > ctx.where_value) {
-                // Since index is sorted, we can stop if we exceeded the value
-                // NOTE: Use a safe compare here. String compare is fine for this exercise.
-                return;
-            }
+            int cmp = Record::compare_column(payload, 0, probe);
+            if (cmp > 0) return; // Sorted, so nothing later can match
+            if (cmp == 0 && matches(payload)) emit_index_match(payload, table_root_page, ctx, row_count);
         }
         
     } else if (type == PageType::InteriorIndex) { // 0x02
         size_t ptr_array_start = header_offset + 12;
-        auto pointers = BTree::parse_cell_pointers(page_data, ptr_array_start, cell_count);
         
-        for (uint16_t ptr : pointers) {
-            size_t cursor = ptr;
+        for (uint16_t i = 0; i < cell_count; ++i) {
+            size_t cursor = BTree::parse_cell_pointer(page_data, ptr_array_start, i);
             uint32_t left_child = Utils::parse_u32(page_data, cursor);
             cursor += 4;
             auto [payload_size, s1] = Utils::read_varint(page_data, cursor);
             cursor += s1;
-            std::vector<char> payload(page_data.begin() + cursor, page_data.begin() + cursor + payload_size);
+            auto payload = read_payload(page_data, cursor, payload_size, true, overflow_buffer);
             
-            std::string key_val = Record::parse_column_to_string(payload, 0);
-            
-            // Logic: Recurse left if key_val >= target (because left has keys <= key_val)
-            // But if key_val < target, the target MUST be in a subsequent branch (or right-most)
-            
-            if (key_val >= ctx.where_value) {
-                scan_index(left_child, table_root_page, ctx, row_count);
-                // If key_val > target, then target cannot be in subsequent branches (since they are > key_val)
-                if (key_val > ctx.where_value) return; 
+            // The left subtree holds keys <= this cell's key, so it can only match if key >= probe
+            int cmp = Record::compare_column(payload, 0, probe);
+            if (cmp >= 0) {
+                scan_index(left_child, table_root_page, probe, ctx, row_count);
+                // Interior index cells carry a real entry that sits between the two subtrees
+                // (payload views this frame's page or overflow buffer, so it survives the recursion)
+                if (cmp == 0 && matches(payload)) emit_index_match(payload, table_root_page, ctx, row_count);
+                // Everything to the right sorts after a key that is already past the probe
+                if (cmp > 0) return;
             }
         }
         
         // Right-most pointer
         uint32_t right_most = BTree::get_right_most_pointer(page_data, header_offset);
-        scan_index(right_most, table_root_page, ctx, row_count);
+        scan_index(right_most, table_root_page, probe, ctx, row_count);
     }
 }
 
-void Database::scan_table(uint32_t page_num, const QueryContext& ctx, int& row_count) {
-    size_t offset = (static_cast<size_t>(page_num) - 1) * page_size;
-    std::vector<char> page_data = pager.read_bytes(offset, page_size);
+void Database::scan_table(uint32_t page_num, const QueryContext& ctx, uint64_t& row_count) {
+    std::pmr::vector<char> page_data(memory);
+    read_page(page_num, page_data);
     size_t header_offset = (page_num == 1) ? 100 : 0;
     
     PageType type = BTree::get_page_type(page_data, header_offset);
@@ -166,44 +269,41 @@ void Database::scan_table(uint32_t page_num, const QueryContext& ctx, int& row_c
 
     if (type == PageType::LeafTable) {
         size_t ptr_array_start = header_offset + 8;
-        auto pointers = BTree::parse_cell_pointers(page_data, ptr_array_start, cell_count);
+        std::pmr::vector<char> overflow_buffer(memory);
+        NumberBuffer scratch;
 
-        for (uint16_t ptr : pointers) {
-            size_t cursor = ptr;
+        for (uint16_t i = 0; i < cell_count; ++i) {
+            size_t cursor = BTree::parse_cell_pointer(page_data, ptr_array_start, i);
             auto [payload_size, s1] = Utils::read_varint(page_data, cursor);
             cursor += s1;
             auto [row_id, s2] = Utils::read_varint(page_data, cursor);
             cursor += s2;
-            std::vector<char> record_payload(page_data.begin() + cursor, 
-                                             page_data.begin() + cursor + payload_size);
+            // Skipping the payload also skips its overflow chain, e.g. for a bare COUNT(*)
+            std::span<const char> record_payload;
+            if (!ctx.decoder->empty()) {
+                record_payload = read_payload(page_data, cursor, payload_size, false, overflow_buffer);
+                ctx.decoder->bind(record_payload);
+            }
             
             if (ctx.where_col_idx != -1) {
-                std::string val;
-                if (ctx.where_is_pk) val = std::to_string(row_id);
-                else val = Record::parse_column_to_string(record_payload, ctx.where_col_idx);
+                std::string_view val;
+                if (ctx.where_is_pk) {
+                    auto [end, ec] = std::to_chars(scratch.data(), scratch.data() + scratch.size(), static_cast<int64_t>(row_id));
+                    val = std::string_view(scratch.data(), end - scratch.data());
+                } else {
+                    val = ctx.decoder->text(ctx.where_slot, record_payload, scratch);
+                }
                 if (val != ctx.where_value) continue;
             }
 
-            if (ctx.count_mode) {
-                row_count++;
-            } else {
-                for (size_t i = 0; i < ctx.targets.size(); ++i) {
-                    std::string val;
-                    if (ctx.targets[i].is_primary_key) val = std::to_string(row_id);
-                    else val = Record::parse_column_to_string(record_payload, ctx.targets[i].index);
-                    std::cout << val << (i == ctx.targets.size() - 1 ? "" : "|");
-                }
-                std::cout << std::endl;
-            }
+            emit_row(static_cast<int64_t>(row_id), record_payload, ctx, row_count);
         }
     } else if (type == PageType::InteriorTable) {
         size_t ptr_array_start = header_offset + 12;
-        auto pointers = BTree::parse_cell_pointers(page_data, ptr_array_start, cell_count);
 
-        for (uint16_t ptr : pointers) {
-            size_t cursor = ptr;
-            std::vector<char> cell_slice(page_data.begin() + cursor, page_data.begin() + cursor + 4);
-            uint32_t left_child = BTree::parse_interior_cell_left_child(cell_slice);
+        for (uint16_t i = 0; i < cell_count; ++i) {
+            size_t cursor = BTree::parse_cell_pointer(page_data, ptr_array_start, i);
+            uint32_t left_child = BTree::parse_interior_cell_left_child(std::span<const char>(page_data).subspan(cursor, 4));
             scan_table(left_child, ctx, row_count);
         }
         uint32_t right_most = BTree::get_right_most_pointer(page_data, header_offset);
@@ -211,23 +311,290 @@ void Database::scan_table(uint32_t page_num, const QueryContext& ctx, int& row_c
     }
 }
 
+void Database::for_each_row(uint32_t page_num, const std::function<void(int64_t, std::span<const char>)>& visit) {
+    std::pmr::vector<char> page_data(memory);
+    read_page(page_num, page_data);
+    size_t header_offset = (page_num == 1) ? 100 : 0;
+
+    PageType type = BTree::get_page_type(page_data, header_offset);
+    uint16_t cell_count = BTree::parse_cell_count(page_data, header_offset);
+
+    if (type == PageType::LeafTable) {
+        std::pmr::vector<char> overflow_buffer(memory);
+        for (uint16_t i = 0; i < cell_count; ++i) {
+            size_t cursor = BTree::parse_cell_pointer(page_data, header_offset + 8, i);
+            auto [payload_size, s1] = Utils::read_varint(page_data, cursor);
+            cursor += s1;
+            auto [row_id, s2] = Utils::read_varint(page_data, cursor);
+            cursor += s2;
+            visit(static_cast<int64_t>(row_id), read_payload(page_data, cursor, payload_size, false, overflow_buffer));
+        }
+    } else if (type == PageType::InteriorTable) {
+        for (uint16_t i = 0; i < cell_count; ++i) {
+            for_each_row(Utils::parse_u32(page_data, BTree::parse_cell_pointer(page_data, header_offset + 12, i)), visit);
+        }
+        for_each_row(BTree::get_right_most_pointer(page_data, header_offset), visit);
+    }
+}
+
+TreeShape Database::estimate_tree_shape(uint32_t root_page) {
+    // Follow the leftmost path and multiply fanouts; costs `depth` page reads
+    TreeShape shape;
+    uint32_t page_num = root_page;
+    std::pmr::vector<char> page_data(memory);
+    std::pmr::vector<uint32_t> siblings(memory); // Children of the last interior page on the path
+    while (true) {
+        read_page(page_num, page_data);
+        size_t header_offset = (page_num == 1) ? 100 : 0;
+        PageType type = BTree::get_page_type(page_data, header_offset);
+        uint16_t cell_count = BTree::parse_cell_count(page_data, header_offset);
+
+        if (type != PageType::InteriorTable && type != PageType::InteriorIndex) {
+            shape.entries_per_leaf = std::max<uint64_t>(cell_count, 1);
+            break;
+        }
+        shape.leaf_pages *= static_cast<uint64_t>(cell_count) + 1;
+        shape.depth++;
+
+        siblings.clear();
+        for (uint16_t i = 0; i < cell_count; ++i) {
+            siblings.push_back(Utils::parse_u32(page_data, BTree::parse_cell_pointer(page_data, header_offset + 12, i)));
+        }
+        siblings.push_back(BTree::get_right_most_pointer(page_data, header_offset));
+        page_num = siblings.front();
+    }
+
+    // Overflow pages per entry, sampled from the leftmost leaf and, when that holds only a few
+    // (large) rows, its next siblings. Every chain page but the last is full
+    static constexpr uint64_t min_sampled_entries = 64;
+    static constexpr size_t max_sampled_leaves = 16;
+    uint64_t sampled_entries = 0;
+    uint64_t overflow_pages = 0;
+    for (size_t leaf = 0; ; ++leaf) {
+        size_t header_offset = (page_num == 1) ? 100 : 0;
+        PageType type = BTree::get_page_type(page_data, header_offset);
+        if (type != PageType::LeafTable && type != PageType::LeafIndex) break;
+        uint16_t cell_count = BTree::parse_cell_count(page_data, header_offset);
+        for (uint16_t i = 0; i < cell_count; ++i) {
+            size_t cursor = BTree::parse_cell_pointer(page_data, header_offset + 8, i);
+            uint64_t payload_size = Utils::read_varint(page_data, cursor).first;
+            uint64_t spilled = payload_size - BTree::local_payload_size(payload_size, usable_size, type == PageType::LeafIndex);
+            overflow_pages += (spilled + usable_size - 5) / (usable_size - 4);
+        }
+        sampled_entries += cell_count;
+
+        if (sampled_entries >= min_sampled_entries || leaf + 1 >= std::min(siblings.size(), max_sampled_leaves)) break;
+        page_num = siblings[leaf + 1];
+        read_page(page_num, page_data);
+    }
+    if (sampled_entries > 0) shape.overflow_per_entry = static_cast<double>(overflow_pages) / sampled_entries;
+    return shape;
+}
+
+std::map<std::string, std::vector<uint64_t>> Database::load_stat1(const std::vector<SchemaObject>& schema, const std::string& table) {
+    // sqlite_stat1(tbl, idx, stat): stat is "nRow avgEq1 avgEq2 ..."; idx is NULL for the table itself
+    std::map<std::string, std::vector<uint64_t>> stats;
+    int64_t stat_root = Schema::get_root_page_number(schema, "sqlite_stat1");
+    if (stat_root <= 0) return stats;
+
+    for_each_row(static_cast<uint32_t>(stat_root), [&](int64_t, std::span<const char> row) {
+        if (Record::parse_column_to_string(row, 0) != table) return;
+        std::istringstream ss(Record::parse_column_to_string(row, 2));
+        std::vector<uint64_t> values;
+        uint64_t value;
+        while (ss >> value) values.push_back(value); // Stops at trailing options like "unordered"
+        stats[Record::parse_column_to_string(row, 1)] = values;
+    });
+    return stats;
+}
+
+std::optional<double> Database::stat4_matches(const std::vector<SchemaObject>& schema, const std::string& index_name, const std::string& value) {
+    // sqlite_stat4(tbl, idx, neq, nlt, ndlt, sample): sample is an index record; neq's first number
+    // is the exact count of entries whose first key column equals the sample's
+    int64_t stat_root = Schema::get_root_page_number(schema, "sqlite_stat4");
+    if (stat_root <= 0) return std::nullopt;
+
+    // Columns are read as views into the row, so sampling allocates nothing per stat4 row
+    std::optional<double> matches;
+    NumberBuffer scratch;
+    for_each_row(static_cast<uint32_t>(stat_root), [&](int64_t, std::span<const char> row) {
+        if (matches || Record::column_text(row, 1, scratch) != index_name) return;
+        std::span<const char> sample = Record::column_bytes(row, 5);
+        if (sample.empty() || Record::column_text(sample, 0, scratch) != value) return;
+        std::string_view neq_list = Record::column_text(row, 2, scratch);
+        uint64_t neq;
+        auto [end, ec] = std::from_chars(neq_list.data(), neq_list.data() + neq_list.size(), neq);
+        if (ec == std::errc()) matches = static_cast<double>(neq);
+    });
+    return matches;
+}
+
+void Database::enable_columnar_cache(const std::vector<std::string>& tables) {
+    columnar_opt_in.insert(tables.begin(), tables.end());
+}
+
+const ColumnarTable& Database::columnar_snapshot(const std::string& table, uint32_t root_page) {
+    CacheStamp stamp = current_stamp();
+    auto it = columnar_tables.find(table);
+    if (it != columnar_tables.end() && it->second.stamp == stamp) return it->second;
+
+    ColumnarTable snapshot;
+    snapshot.stamp = stamp;
+    std::vector<Value> values;
+    for_each_row(root_page, [&](int64_t row_id, std::span<const char> payload) {
+        Record::parse_values(payload, values);
+        snapshot.append_row(row_id, values);
+    });
+    return columnar_tables[table] = std::move(snapshot);
+}
+
+void Database::scan_columnar(const ColumnarTable& snapshot, const QueryContext& ctx, uint64_t& row_count) {
+    std::pmr::string line(memory);
+    NumberBuffer scratch;
+    auto emit = [&](size_t row) {
+        line.clear();
+        for (size_t i = 0; i < ctx.targets.size(); ++i) {
+            if (ctx.targets[i].is_primary_key) {
+                auto [end, ec] = std::to_chars(scratch.data(), scratch.data() + scratch.size(), snapshot.rowid(row));
+                line.append(scratch.data(), end);
+            } else {
+                line += snapshot.format(ctx.targets[i].index, row, scratch);
+            }
+            if (i != ctx.targets.size() - 1) line += '|';
+        }
+        line += '\n';
+        ctx.out->write(line.data(), static_cast<std::streamsize>(line.size()));
+    };
+
+    if (ctx.where_col_idx == -1) {
+        if (ctx.count_mode) {
+            row_count += snapshot.row_count();
+            return;
+        }
+        for (size_t row = 0; row < snapshot.row_count(); ++row) emit(row);
+        return;
+    }
+
+    auto rows = ctx.where_is_pk ? snapshot.select_rowid(ctx.where_value, memory)
+                                : snapshot.select_equal(ctx.where_col_idx, ctx.where_value, memory);
+    if (ctx.count_mode) {
+        row_count += rows.size();
+        return;
+    }
+    for (uint32_t row : rows) emit(row);
+}
+
+void Database::enable_result_cache(const ResultCacheOptions& options) {
+    result_cache.emplace(options);
+    if (!result_cache->enabled()) result_cache.reset();
+}
+
+CacheStamp Database::current_stamp() {
+    CacheStamp stamp;
+    std::vector<char> header = pager.read_bytes(0, 100);
+    stamp.change_counter = Utils::parse_u32(header, 24);
+
+    // Read/write format versions of 2 mean WAL mode; committed changes may live only in the -wal file
+    if (header[18] == 2 || header[19] == 2) {
+        std::string wal_path = pager.path() + "-wal";
+        std::error_code ec;
+        uint64_t wal_size = std::filesystem::file_size(wal_path, ec);
+        if (!ec) {
+            stamp.wal_size = wal_size;
+            std::ifstream wal(wal_path, std::ios::binary);
+            std::vector<char> wal_header(32);
+            wal.read(wal_header.data(), wal_header.size());
+            if (wal.gcount() == static_cast<std::streamsize>(wal_header.size())) {
+                stamp.wal_checkpoint = Utils::parse_u32(wal_header, 12);
+                stamp.wal_salt1 = Utils::parse_u32(wal_header, 16);
+                stamp.wal_salt2 = Utils::parse_u32(wal_header, 20);
+            }
+        }
+    }
+    return stamp;
+}
+
 void Database::execute_sql(const std::string& query) {
+    last_query_peak = 0;
+    auto parsed = result_cache ? SQL::parse_select(query) : std::nullopt;
+    if (!parsed) {
+        // No cache, or a query that doesn't parse and only produces an error
+        run_select(query, std::cout);
+        return;
+    }
+
+    std::error_code ec;
+    std::string db_path = std::filesystem::weakly_canonical(pager.path(), ec).string();
+    if (ec) db_path = pager.path();
+    std::string key = db_path + "\n" + SQL::cache_key(*parsed);
+
+    // Stamp before running so a concurrent write can only make the entry look stale, never fresh
+    CacheStamp stamp = current_stamp();
+    if (auto cached = result_cache->lookup(key, stamp)) {
+        std::cout << *cached;
+        return;
+    }
+
+    std::ostringstream out;
+    if (run_select(query, out)) {
+        result_cache->store(key, stamp, out.str());
+    }
+    std::cout << out.str();
+}
+
+bool Database::run_select(const std::string& query, std::ostream& out) {
+    QueryArena arena(query_memory_limit);
+
+    // Route query-lifetime allocations to the arena until this returns or throws
+    struct ArenaScope {
+        Database& db;
+        std::pmr::memory_resource* saved;
+        QueryArena& arena;
+        ~ArenaScope() {
+            db.memory = saved;
+            db.last_query_peak = arena.peak_bytes();
+        }
+    } scope{*this, memory, arena};
+    memory = arena.resource();
+
+    try {
+        if (query_memory_limit == 0) return plan_and_execute(query, out);
+
+        // Under a limit, rows are held in the arena and written only once the query finishes, so a
+        // query that runs out of memory prints its error and no partial result. badbit makes the
+        // stream rethrow the limit error instead of swallowing it
+        ArenaOutputBuffer buffer(arena.resource());
+        std::ostream buffered(&buffer);
+        buffered.exceptions(std::ios::badbit);
+        bool ok = plan_and_execute(query, buffered);
+        out.write(buffer.str().data(), static_cast<std::streamsize>(buffer.str().size()));
+        return ok;
+    } catch (const QueryMemoryLimitExceeded& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Database::plan_and_execute(const std::string& query, std::ostream& out) {
     auto q_opt = SQL::parse_select(query);
     if (!q_opt) {
         std::cerr << "Unsupported query: " << query << std::endl;
-        return;
+        return false;
     }
     
-    std::vector<char> page_1 = pager.read_bytes(0, page_size);
-    int root_page_num = Schema::get_root_page_number(page_1, q_opt->table);
+    std::vector<SchemaObject> schema = read_schema();
+    int64_t root_page_num = Schema::get_root_page_number(schema, q_opt->table);
     if (root_page_num == -1) {
         std::cerr << "Table not found: " << q_opt->table << std::endl;
-        return;
+        return false;
     }
 
     QueryContext ctx;
     ctx.where_value = q_opt->where_value;
     ctx.count_mode = false;
+    ctx.out = &out;
+    ctx.covering = false;
+    ctx.index_rowid_col = 1;
     
     if (q_opt->columns.size() == 1) {
         std::string col_upper = q_opt->columns[0];
@@ -237,47 +604,178 @@ void Database::execute_sql(const std::string& query) {
 
     if (!ctx.count_mode) {
         for (const auto& col_name : q_opt->columns) {
-            ColumnInfo info = Schema::get_column_info(page_1, q_opt->table, col_name);
+            ColumnInfo info = Schema::get_column_info(schema, q_opt->table, col_name);
             if (info.index == -1) {
                 std::cerr << "Column not found: " << col_name << std::endl;
-                return;
+                return false;
             }
             ctx.targets.push_back({info.index, info.is_primary_key});
         }
     }
 
-    bool use_index = false;
-    int index_root = -1;
-
-    if (!q_opt->where_column.empty()) {
-        ColumnInfo info = Schema::get_column_info(page_1, q_opt->table, q_opt->where_column);
+    bool has_predicate = !q_opt->where_column.empty();
+    if (has_predicate) {
+        ColumnInfo info = Schema::get_column_info(schema, q_opt->table, q_opt->where_column);
         if (info.index == -1) {
             std::cerr << "Filter column not found" << std::endl;
-            return;
+            return false;
         }
         ctx.where_col_idx = info.index;
         ctx.where_is_pk = info.is_primary_key;
-
-        // CHECK INDEX: specifically for companies.country
-        if (q_opt->table == "companies" && q_opt->where_column == "country") {
-            index_root = Schema::get_index_root_page(page_1, "idx_companies_country");
-            if (index_root != -1) {
-                use_index = true;
-            }
-        }
     } else {
         ctx.where_col_idx = -1;
         ctx.where_is_pk = false;
     }
 
-    int row_count = 0;
-    if (use_index) {
-        scan_index(index_root, root_page_num, ctx, row_count);
-    } else {
-        scan_table(root_page_num, ctx, row_count);
+    uint32_t table_root = static_cast<uint32_t>(root_page_num);
+
+    // Specialize the row decoder for this table and projection: only these columns are ever located
+    std::pmr::vector<int> projection(memory);
+    ctx.where_slot = -1;
+    if (has_predicate && !ctx.where_is_pk) {
+        ctx.where_slot = static_cast<int>(projection.size());
+        projection.push_back(ctx.where_col_idx);
+    }
+    for (auto& target : ctx.targets) {
+        if (target.is_primary_key) continue;
+        target.slot = static_cast<int>(projection.size());
+        projection.push_back(target.index);
+    }
+    RecordDecoder decoder(projection, memory);
+    ctx.decoder = &decoder;
+
+    // Opted-in tables are answered from their columnar snapshot without touching the B-tree
+    if (columnar_opt_in.contains("*") || columnar_opt_in.contains(q_opt->table)) {
+        const ColumnarTable& snapshot = columnar_snapshot(q_opt->table, table_root);
+        if (q_opt->explain) {
+            out << "QUERY PLAN table=" << q_opt->table << " table_rows=" << snapshot.row_count()
+                << " stats=columnar" << std::endl;
+            out << "* columnar_scan est_rows=" << snapshot.row_count() << " cost=0.0" << std::endl;
+            return true;
+        }
+        uint64_t row_count = 0;
+        scan_columnar(snapshot, ctx, row_count);
+        if (ctx.count_mode) out << row_count << std::endl;
+        return true;
+    }
+
+    // Plan: cost each access path the predicate allows and take the cheapest
+    TreeShape table_shape = estimate_tree_shape(table_root);
+    auto stat1 = (has_predicate || q_opt->explain) ? load_stat1(schema, q_opt->table) : std::map<std::string, std::vector<uint64_t>>{};
+
+    double table_rows = static_cast<double>(table_shape.leaf_pages * table_shape.entries_per_leaf);
+    std::string table_rows_source = "estimate";
+    if (!stat1.empty() && !stat1.begin()->second.empty()) {
+        table_rows = static_cast<double>(stat1.begin()->second[0]);
+        table_rows_source = "stat1";
+    }
+
+    std::vector<IndexCandidate> candidates;
+    std::vector<IndexDef> candidate_defs;
+    if (has_predicate && !ctx.where_is_pk) {
+        for (const auto& def : Schema::get_indexes(schema, q_opt->table)) {
+            if (def.columns[0] != q_opt->where_column) continue;
+
+            IndexCandidate candidate;
+            candidate.name = def.name;
+            candidate.root_page = static_cast<uint32_t>(def.root_page);
+            candidate.key_columns = def.columns.size();
+            candidate.shape = estimate_tree_shape(candidate.root_page);
+
+            // Prefer an exact stat4 sample, then the stat1 average, then SQLite's own default guess
+            if (auto exact = stat4_matches(schema, def.name, q_opt->where_value)) {
+                candidate.est_matches = *exact;
+                candidate.estimate_source = "stat4";
+            } else if (auto it = stat1.find(def.name); it != stat1.end() && it->second.size() > 1) {
+                candidate.est_matches = static_cast<double>(it->second[1]);
+                candidate.estimate_source = "stat1";
+            } else {
+                candidate.est_matches = std::min(table_rows, default_eq_rows);
+                candidate.estimate_source = "default";
+            }
+
+            candidate.covering = true;
+            for (size_t i = 0; i < ctx.targets.size() && candidate.covering; ++i) {
+                if (ctx.targets[i].is_primary_key) continue; // The rowid is in every index entry
+                candidate.covering = std::find(def.columns.begin(), def.columns.end(), q_opt->columns[i]) != def.columns.end();
+            }
+            candidates.push_back(candidate);
+            candidate_defs.push_back(def);
+        }
+    }
+
+    double predicate_rows = table_rows;
+    if (ctx.where_is_pk) {
+        predicate_rows = 1;
+    } else if (has_predicate) {
+        // Take the estimate from the most specific statistics any candidate had
+        predicate_rows = std::min(table_rows, default_eq_rows);
+        auto source_rank = [](const std::string& source) { return source == "stat4" ? 2 : source == "stat1" ? 1 : 0; };
+        int best_rank = -1;
+        for (const auto& candidate : candidates) {
+            if (source_rank(candidate.estimate_source) > best_rank) {
+                best_rank = source_rank(candidate.estimate_source);
+                predicate_rows = candidate.est_matches;
+            }
+        }
+    }
+
+    auto paths = Planner::rank_paths(table_shape, predicate_rows, ctx.where_is_pk, !decoder.empty(), candidates);
+    const AccessPath& chosen = paths.front();
+
+    if (q_opt->explain) {
+        out << "QUERY PLAN table=" << q_opt->table << " table_rows=" << static_cast<uint64_t>(table_rows)
+            << " stats=" << table_rows_source << std::endl;
+        for (const auto& path : paths) {
+            out << (&path == &chosen ? "* " : "  ") << Planner::describe(path, candidates) << std::endl;
+        }
+        return true;
+    }
+
+    uint64_t row_count = 0;
+    switch (chosen.method) {
+        case AccessMethod::FullScan:
+            scan_table(table_root, ctx, row_count);
+            break;
+        case AccessMethod::RowidSeek: {
+            int64_t row_id = 0;
+            const std::string& v = ctx.where_value;
+            auto [end, ec] = std::from_chars(v.data(), v.data() + v.size(), row_id);
+            if (ec == std::errc() && end == v.data() + v.size()) {
+                std::pmr::vector<char> row_payload(memory);
+                if (get_row_by_id(table_root, row_id, row_payload)) {
+                    decoder.bind(row_payload);
+                    emit_row(row_id, row_payload, ctx, row_count);
+                }
+            }
+            break;
+        }
+        case AccessMethod::IndexLookup:
+        case AccessMethod::CoveringIndex: {
+            const IndexCandidate& index = candidates[chosen.index];
+            const IndexDef& def = candidate_defs[chosen.index];
+            ctx.index_rowid_col = static_cast<int>(index.key_columns);
+            ctx.covering = chosen.method == AccessMethod::CoveringIndex;
+            if (ctx.covering) {
+                for (size_t i = 0; i < ctx.targets.size(); ++i) {
+                    if (ctx.targets[i].is_primary_key) {
+                        ctx.index_positions.push_back(ctx.index_rowid_col);
+                    } else {
+                        auto it = std::find(def.columns.begin(), def.columns.end(), q_opt->columns[i]);
+                        ctx.index_positions.push_back(static_cast<int>(it - def.columns.begin()));
+                    }
+                }
+            }
+            // One descent per storage class the literal could match, in index order
+            for (const KeyProbe& probe : Record::key_probes(ctx.where_value)) {
+                scan_index(index.root_page, table_root, probe, ctx, row_count);
+            }
+            break;
+        }
     }
 
     if (ctx.count_mode) {
-        std::cout << row_count << std::endl;
+        out << row_count << std::endl;
     }
+    return true;
 }
\ No newline at end of file
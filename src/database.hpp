@@ -1,12 +1,27 @@
 #pragma once
 #include "pager.hpp"
+#include "schema.hpp"
+#include "result_cache.hpp"
+#include "planner.hpp"
+#include "columnar.hpp"
+#include "arena.hpp"
+#include "decoder.hpp"
+#include "analyzer.hpp"
 #include <string>
 #include <vector>
 #include <optional>
+#include <functional>
+#include <map>
+#include <set>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <memory_resource>
 
 struct ColumnTarget {
     int index;
     bool is_primary_key;
+    int slot = -1; // Position in the query's RecordDecoder projection
 };
 
 struct QueryContext {
@@ -15,24 +30,85 @@ struct QueryContext {
     bool where_is_pk;
     std::string where_value;
     bool count_mode;
+    std::ostream* out;
+
+    // Table rows are decoded through a plan-time decoder; the filter column has its own slot
+    RecordDecoder* decoder;
+    int where_slot;
+
+    // Index paths: where the rowid sits in each index entry, and for covering scans
+    // the index entry column that supplies each target
+    int index_rowid_col;
+    bool covering;
+    std::vector<int> index_positions;
 };
 
 class Database {
 private:
     Pager pager;
-    uint16_t page_size; 
+    uint32_t page_size;    // 512..65536; header stores 65536 as 1
+    uint32_t usable_size;  // page_size minus the reserved bytes at the end of every page
+    uint64_t page_count;
+    std::optional<ResultCache> result_cache;
+    std::set<std::string> columnar_opt_in; // Table names, or "*" for every table
+    std::map<std::string, ColumnarTable> columnar_tables;
+
+    // Allocator for query-lifetime buffers: the running query's arena, else the default heap
+    std::pmr::memory_resource* memory = std::pmr::get_default_resource();
+    size_t query_memory_limit = 0; // Bytes per query; 0 is unlimited
+    size_t last_query_peak = 0;
 
-    void scan_table(uint32_t page_num, const QueryContext& ctx, int& row_count);
+    void read_page(uint32_t page_num, std::pmr::vector<char>& out);
+
+    // Returns the cell payload starting at `cursor`. Local payloads are a view into `page_data`;
+    // payloads that spill to overflow pages are assembled into `overflow_buffer`
+    std::span<const char> read_payload(std::span<const char> page_data, size_t cursor, uint64_t payload_size, bool is_index,
+                                       std::pmr::vector<char>& overflow_buffer);
+
+    void scan_table(uint32_t page_num, const QueryContext& ctx, uint64_t& row_count);
     
-    // New: Index Scan logic
-    void scan_index(uint32_t page_num, uint32_t table_root_page, const QueryContext& ctx, int& row_count);
+    // New: Index Scan logic. Emits entries whose first key column equals `probe` in SQLite's
+    // key order and displays as the WHERE literal
+    void scan_index(uint32_t page_num, uint32_t table_root_page, const KeyProbe& probe, const QueryContext& ctx, uint64_t& row_count);
+    // `row_payload` must already be bound to ctx.decoder
+    void emit_row(int64_t row_id, std::span<const char> row_payload, const QueryContext& ctx, uint64_t& row_count);
+    void emit_index_match(std::span<const char> index_payload, uint32_t table_root_page, const QueryContext& ctx, uint64_t& row_count);
     
-    // New: Fetch row by ID
-    std::optional<std::vector<char>> get_row_by_id(uint32_t page_num, int64_t row_id);
+    // New: Fetch row by ID into `out`; false if the rowid is absent
+    bool get_row_by_id(uint32_t page_num, int64_t row_id, std::pmr::vector<char>& out);
+
+    // Columnar snapshot of a table, rebuilt only when the file's stamp has moved
+    const ColumnarTable& columnar_snapshot(const std::string& table, uint32_t root_page);
+    void scan_columnar(const ColumnarTable& snapshot, const QueryContext& ctx, uint64_t& row_count);
+
+    // Every sqlite_schema row, read through the page-1 B-tree (interior pages and overflow included)
+    std::vector<SchemaObject> read_schema();
+
+    // Visits every row of a table B-tree as (rowid, record payload)
+    void for_each_row(uint32_t page_num, const std::function<void(int64_t, std::span<const char>)>& visit);
+
+    // Planner inputs: tree shape from one descent, and sqlite_stat1 / sqlite_stat4 read through the catalog
+    TreeShape estimate_tree_shape(uint32_t root_page);
+    std::map<std::string, std::vector<uint64_t>> load_stat1(const std::vector<SchemaObject>& schema, const std::string& table);
+    std::optional<double> stat4_matches(const std::vector<SchemaObject>& schema, const std::string& index_name, const std::string& value);
+
+    // Runs a SELECT inside a fresh arena, writing rows to `out`. Returns false if the query was
+    // rejected or ran out of memory
+    bool run_select(const std::string& query, std::ostream& out);
+    bool plan_and_execute(const std::string& query, std::ostream& out);
+
+    // Re-reads the header (and WAL header, if any) without touching table pages
+    CacheStamp current_stamp();
 
 public:
     explicit Database(const std::string& filename);
     void print_db_info();
     void list_tables();
+    // One JSON line per table and index B-tree (sqlite_schema first) describing its physical shape
+    void analyze_storage();
+    void enable_result_cache(const ResultCacheOptions& options);
+    void enable_columnar_cache(const std::vector<std::string>& tables);
+    void set_query_memory_limit(size_t bytes) { query_memory_limit = bytes; }
+    size_t last_query_peak_bytes() const { return last_query_peak; }
     void execute_sql(const std::string& query);
-};
\ No newline at end of file
+};
@@ -0,0 +1,132 @@
+#include "decoder.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+
+template <size_t Bytes>
+static std::string_view int_text(const char* body, size_t, NumberBuffer& scratch) {
+    // Width is a compile-time constant, so this unrolls to a fixed sequence of shifts
+    uint64_t value = 0;
+    for (size_t i = 0; i < Bytes; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(body[i]);
+    }
+    if constexpr (Bytes < 8) {
+        if ((value >> (Bytes * 8 - 1)) & 1) value |= ~uint64_t{0} << (Bytes * 8);
+    }
+    auto [end, ec] = std::to_chars(scratch.data(), scratch.data() + scratch.size(), static_cast<int64_t>(value));
+    return std::string_view(scratch.data(), end - scratch.data());
+}
+
+static std::string_view real_text(const char* body, size_t, NumberBuffer& scratch) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        bits = (bits << 8) | static_cast<unsigned char>(body[i]);
+    }
+    return Record::format_real(std::bit_cast<double>(bits), scratch);
+}
+
+template <char Digit>
+static std::string_view constant_text(const char*, size_t, NumberBuffer&) {
+    static constexpr char text[1] = {Digit};
+    return std::string_view(text, 1);
+}
+
+static std::string_view string_text(const char* body, size_t size, NumberBuffer&) {
+    return std::string_view(body, size);
+}
+
+static std::string_view empty_text(const char*, size_t, NumberBuffer&) {
+    // NULL, BLOB and columns missing from short rows all display as ""
+    return {};
+}
+
+RecordDecoder::RecordDecoder(std::span<const int> columns, std::pmr::memory_resource* memory)
+    : slots(memory), cached_header(memory), column_types(memory), column_offsets(memory) {
+    slots.reserve(columns.size());
+    for (int column : columns) {
+        slots.push_back(Slot{column});
+        max_column = std::max(max_column, column);
+    }
+    column_types.resize(max_column + 1);
+    column_offsets.resize(max_column + 1);
+}
+
+RecordDecoder::TextKernel RecordDecoder::kernel_for(int64_t serial_type) {
+    switch (serial_type) {
+        case 1: return int_text<1>;
+        case 2: return int_text<2>;
+        case 3: return int_text<3>;
+        case 4: return int_text<4>;
+        case 5: return int_text<6>;
+        case 6: return int_text<8>;
+        case 7: return real_text;
+        case 8: return constant_text<'0'>;
+        case 9: return constant_text<'1'>;
+        default: return (serial_type >= 13 && serial_type % 2 == 1) ? string_text : empty_text;
+    }
+}
+
+void RecordDecoder::bind(std::span<const char> record_payload) {
+    auto [header_size, header_varint_len] = Utils::read_varint(record_payload, 0);
+    if (!caching) {
+        bind_generic(record_payload, header_size, header_varint_len);
+        return;
+    }
+
+    // Fast path: same header prefix as the previous row means same offsets and kernels
+    if (!cached_header.empty() && cached_min_size <= record_payload.size() &&
+        std::memcmp(record_payload.data(), cached_header.data(), cached_header.size()) == 0) {
+        ++hits;
+        return;
+    }
+    ++misses;
+    bind_generic(record_payload, header_size, header_varint_len);
+
+    // Tables whose prefixes keep changing (e.g. varying integer widths before a projected
+    // column) pay for the compare and the copy without ever hitting; decode those generically
+    if (misses == probe_rows && hits < misses) {
+        caching = false;
+        cached_header.clear();
+    }
+}
+
+void RecordDecoder::bind_generic(std::span<const char> record_payload, size_t header_size, size_t header_varint_len) {
+    // Only walk as far as the highest projected column
+    size_t cursor = header_varint_len;
+    size_t body_cursor = header_size;
+    int present = 0;
+    while (cursor < header_size && present <= max_column) {
+        auto [type, len] = Utils::read_varint(record_payload, cursor);
+        cursor += len;
+        column_types[present] = static_cast<int64_t>(type);
+        column_offsets[present] = body_cursor;
+        body_cursor += Record::get_serial_type_size(type);
+        ++present;
+    }
+
+    cached_min_size = header_size;
+    for (Slot& slot : slots) {
+        slot.offset = 0;
+        slot.size = 0;
+        slot.kernel = empty_text;
+        if (slot.column >= present) continue;
+
+        int64_t type = column_types[slot.column];
+        size_t size = Record::get_serial_type_size(type);
+        if (column_offsets[slot.column] + size > record_payload.size()) continue; // Malformed; read as empty
+        slot.offset = column_offsets[slot.column];
+        slot.size = size;
+        slot.kernel = kernel_for(type);
+        cached_min_size = std::max(cached_min_size, slot.offset + slot.size);
+    }
+
+    // The prefix starts with the header-size varint, so a match also implies the same body start.
+    // Headers that run past the payload are never cached
+    if (caching && cursor <= record_payload.size()) {
+        cached_header.assign(record_payload.data(), record_payload.data() + cursor);
+    } else {
+        cached_header.clear();
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "record.hpp"
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Record decoder specialized at plan time for one table and one projection.
+// Rows in a table usually repeat the same serial-type header (same column count,
+// same integer widths, often the same text lengths). Projected offsets depend only
+// on the header bytes up to the highest projected column, so when that prefix is
+// byte-identical to the previous row's, the cached offsets and per-type kernels are
+// reused and the header walk is skipped entirely.
+class RecordDecoder {
+public:
+    // Formats one column body; instantiated per serial type so the hot path has no type switch
+    using TextKernel = std::string_view (*)(const char* body, size_t size, NumberBuffer& scratch);
+
+    // `columns` are the record column indices the query reads; each gets a slot, in order.
+    // All of the decoder's buffers come from `memory`, the running query's arena
+    RecordDecoder(std::span<const int> columns, std::pmr::memory_resource* memory);
+
+    // Prepares the slots for `record_payload`; must be called before text() for each row
+    void bind(std::span<const char> record_payload);
+
+    std::string_view text(size_t slot, std::span<const char> record_payload, NumberBuffer& scratch) const {
+        const Slot& s = slots[slot];
+        return s.kernel(record_payload.data() + s.offset, s.size, scratch);
+    }
+
+    // No projected columns: rows can be answered from the rowid alone, without their payload
+    bool empty() const { return slots.empty(); }
+
+private:
+    struct Slot {
+        int column;
+        size_t offset = 0;
+        size_t size = 0;
+        TextKernel kernel = nullptr;
+    };
+
+    std::pmr::vector<Slot> slots;
+    int max_column = -1;
+    std::pmr::vector<char> cached_header;    // Header prefix (through the last projected column) of the last bound row
+    size_t cached_min_size = 0;              // Payload bytes the cached slots reach into
+    std::pmr::vector<int64_t> column_types;  // Scratch for the generic walk, sized once
+    std::pmr::vector<size_t> column_offsets;
+    uint64_t hits = 0;                       // Header prefix matches and mismatches; they decide whether caching pays
+    uint64_t misses = 0;
+    bool caching = true;                     // Cleared once the prefix has proven too unstable to be worth comparing
+    static constexpr uint64_t probe_rows = 256;
+
+    void bind_generic(std::span<const char> record_payload, size_t header_size, size_t header_varint_len);
+    static TextKernel kernel_for(int64_t serial_type);
+};
@@ -1,7 +1,24 @@
 #include <iostream>
 #include <string>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+#include <string_view>
+#include <charconv>
+#include <stdexcept>
 #include "database.hpp"
 
+// Reads a byte-count environment variable, naming the variable if its value isn't a plain number
+static uint64_t parse_byte_count(const char* variable, const char* value) {
+    std::string_view text(value);
+    uint64_t bytes = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), bytes);
+    if (text.empty() || ec != std::errc() || end != text.data() + text.size()) {
+        throw std::runtime_error(std::string(variable) + " must be a byte count, got '" + value + "'");
+    }
+    return bytes;
+}
+
 int main(int argc, char* argv[]) {
     std::cout << std::unitbuf;
     std::cerr << std::unitbuf;
@@ -12,17 +29,56 @@ int main(int argc, char* argv[]) {
     }
 
     std::string database_file_path = argv[1];
-    std::string command = argv[2];
 
     try {
         Database db(database_file_path);
 
-        if (command == ".dbinfo") {
-            db.print_db_info();
-        } else if (command == ".tables") {
-            db.list_tables();
-        } else {
-            db.execute_sql(command);
+        // Opt-in query result cache, persisted across runs when a spill directory is given
+        const char* cache_dir = std::getenv("SQLITE_RESULT_CACHE_DIR");
+        const char* cache_max = std::getenv("SQLITE_RESULT_CACHE_MAX_BYTES");
+        const char* cache_max_disk = std::getenv("SQLITE_RESULT_CACHE_MAX_DISK_BYTES");
+        if (cache_dir || cache_max) {
+            ResultCacheOptions cache_options;
+            if (cache_dir) cache_options.spill_dir = cache_dir;
+            if (cache_max) cache_options.max_memory_bytes = parse_byte_count("SQLITE_RESULT_CACHE_MAX_BYTES", cache_max);
+            if (cache_max_disk) {
+                cache_options.max_disk_bytes = parse_byte_count("SQLITE_RESULT_CACHE_MAX_DISK_BYTES", cache_max_disk);
+            }
+            db.enable_result_cache(cache_options);
+        }
+
+        // Opt-in columnar snapshots: comma-separated table names, or "*" for all tables
+        if (const char* columnar = std::getenv("SQLITE_COLUMNAR_TABLES")) {
+            std::vector<std::string> tables;
+            std::stringstream ss(columnar);
+            std::string table;
+            while (std::getline(ss, table, ',')) {
+                if (!table.empty()) tables.push_back(table);
+            }
+            db.enable_columnar_cache(tables);
+        }
+
+        // Per-query arena cap, and an opt-in report of each query's peak arena usage on stderr
+        if (const char* limit = std::getenv("SQLITE_QUERY_MEMORY_LIMIT")) {
+            db.set_query_memory_limit(parse_byte_count("SQLITE_QUERY_MEMORY_LIMIT", limit));
+        }
+        bool report_memory = std::getenv("SQLITE_QUERY_MEMORY_REPORT") != nullptr;
+
+        // Several commands may follow the database path; they share one Database and its caches
+        for (int i = 2; i < argc; ++i) {
+            std::string command = argv[i];
+            if (command == ".dbinfo") {
+                db.print_db_info();
+            } else if (command == ".tables") {
+                db.list_tables();
+            } else if (command == ".analyze") {
+                db.analyze_storage();
+            } else {
+                db.execute_sql(command);
+                if (report_memory) {
+                    std::cerr << "query memory peak: " << db.last_query_peak_bytes() << " bytes" << std::endl;
+                }
+            }
         }
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
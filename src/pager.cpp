@@ -7,21 +7,33 @@ Pager::Pager(const std::string& path) : file_path(path) {
     if (!file) {
         throw std::runtime_error("Failed to open database file: " + path);
     }
+    file_size = static_cast<uint64_t>(file.tellg());
     file.seekg(0, std::ios::beg);
 }
 
-std::vector<char> Pager::read_bytes(size_t offset, size_t size) {
-    file.seekg(offset);
+std::vector<char> Pager::read_bytes(uint64_t offset, size_t size) {
+    std::vector<char> buffer(size);
+    read_into(offset, buffer);
+    return buffer;
+}
+
+void Pager::read_into(uint64_t offset, std::span<char> out) {
+    file.seekg(static_cast<std::streamoff>(offset));
     if (file.fail()) {
          throw std::runtime_error("Seek failed");
     }
 
-    std::vector<char> buffer(size);
-    file.read(buffer.data(), size);
+    file.read(out.data(), out.size());
     
-    if (file.gcount() != static_cast<std::streamsize>(size)) {
+    if (file.gcount() != static_cast<std::streamsize>(out.size())) {
         throw std::runtime_error("Failed to read required bytes");
     }
-    
-    return buffer;
-}
\ No newline at end of file
+}
+
+void Pager::read_page(uint32_t page_num, std::span<char> out) {
+    if (page_num == 0) {
+        throw std::runtime_error("Invalid page number 0");
+    }
+    uint64_t offset = (static_cast<uint64_t>(page_num) - 1) * out.size();
+    read_into(offset, out);
+}
@@ -2,15 +2,28 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <span>
 
 class Pager {
 private:
     std::ifstream file;
     std::string file_path;
+    uint64_t file_size;
 
 public:
     explicit Pager(const std::string& path);
     
     // Reads a specific number of bytes from an absolute offset
-    std::vector<char> read_bytes(size_t offset, size_t size);
-};
\ No newline at end of file
+    std::vector<char> read_bytes(uint64_t offset, size_t size);
+
+    // Fills `out` from an absolute offset, so callers can supply their own (pooled) buffers
+    void read_into(uint64_t offset, std::span<char> out);
+
+    // Reads a whole page into `out`, whose size is the page size. Page numbers are 1-based,
+    // offsets are 64-bit so files past 4GB work
+    void read_page(uint32_t page_num, std::span<char> out);
+
+    uint64_t size() const { return file_size; }
+    const std::string& path() const { return file_path; }
+};
@@ -0,0 +1,58 @@
+#include "planner.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+std::vector<AccessPath> Planner::rank_paths(const TreeShape& table_shape, double predicate_rows, bool rowid_predicate,
+                                            bool reads_payload, const std::vector<IndexCandidate>& indexes) {
+    std::vector<AccessPath> paths;
+
+    // A full scan reads every leaf once, plus the interior levels above them, plus every row's
+    // overflow chain when columns are decoded
+    double interior_pages = std::ceil(static_cast<double>(table_shape.leaf_pages) / std::max<uint64_t>(table_shape.entries_per_leaf, 2));
+    double table_entries = static_cast<double>(table_shape.leaf_pages * table_shape.entries_per_leaf);
+    double scan_overflow = reads_payload ? table_entries * table_shape.overflow_per_entry : 0.0;
+    paths.push_back({AccessMethod::FullScan, -1, predicate_rows,
+                     static_cast<double>(table_shape.leaf_pages) + interior_pages + scan_overflow});
+
+    // Fetched rows are assembled whole, overflow included
+    double row_fetch = table_shape.depth + table_shape.overflow_per_entry;
+    if (rowid_predicate) {
+        paths.push_back({AccessMethod::RowidSeek, -1, 1.0, row_fetch});
+    }
+
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        const IndexCandidate& idx = indexes[i];
+        double matches = std::max(idx.est_matches, 1.0);
+        // Descend once, then walk the matching run of leaf entries and any overflow they carry
+        double index_cost = idx.shape.depth + std::ceil(matches / std::max<uint64_t>(idx.shape.entries_per_leaf, 1)) +
+                            matches * idx.shape.overflow_per_entry;
+        if (idx.covering) {
+            paths.push_back({AccessMethod::CoveringIndex, static_cast<int>(i), matches, index_cost});
+        } else {
+            // Each match costs a full descent of the table B-tree
+            paths.push_back({AccessMethod::IndexLookup, static_cast<int>(i), matches, index_cost + matches * row_fetch});
+        }
+    }
+
+    std::stable_sort(paths.begin(), paths.end(), [](const AccessPath& a, const AccessPath& b) {
+        return a.cost < b.cost;
+    });
+    return paths;
+}
+
+std::string Planner::describe(const AccessPath& path, const std::vector<IndexCandidate>& indexes) {
+    std::string name;
+    switch (path.method) {
+        case AccessMethod::FullScan: name = "full_scan"; break;
+        case AccessMethod::RowidSeek: name = "rowid_seek"; break;
+        case AccessMethod::IndexLookup: name = "index_lookup " + indexes[path.index].name; break;
+        case AccessMethod::CoveringIndex: name = "covering_index " + indexes[path.index].name; break;
+    }
+
+    char estimates[96];
+    std::snprintf(estimates, sizeof(estimates), " est_rows=%.0f cost=%.1f", path.est_rows, path.cost);
+    std::string line = name + estimates;
+    if (path.index != -1) line += " stats=" + indexes[path.index].estimate_source;
+    return line;
+}
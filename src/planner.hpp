@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class AccessMethod {
+    FullScan,      // Visit every leaf of the table B-tree
+    RowidSeek,     // Single descent of the table B-tree by rowid
+    IndexLookup,   // Index range on the first key column, then get_row_by_id per match
+    CoveringIndex  // Index range only; every needed column lives in the index entry
+};
+
+// Approximate B-tree shape from one root-to-leftmost-leaf descent
+struct TreeShape {
+    int depth = 1;
+    uint64_t leaf_pages = 1;
+    uint64_t entries_per_leaf = 1;
+    double overflow_per_entry = 0; // Overflow pages behind an average entry of the sampled leaf
+};
+
+struct IndexCandidate {
+    std::string name;
+    uint32_t root_page;
+    size_t key_columns;      // Number of indexed columns; the rowid sits right after them
+    TreeShape shape;
+    double est_matches;      // Rows expected to equal the predicate value
+    bool covering;
+    std::string estimate_source; // "stat4", "stat1" or "default"
+};
+
+struct AccessPath {
+    AccessMethod method;
+    int index = -1;          // Position in the candidate list for index paths
+    double est_rows;         // Rows the path is expected to return
+    double cost;             // Estimated page reads
+};
+
+class Planner {
+public:
+    // Costs every applicable path and returns them cheapest first; front() is the chosen plan
+    // `predicate_rows` is the expected result size (table_rows when there is no WHERE clause).
+    // `reads_payload` is false when a full scan needs only rowids and can skip overflow chains
+    static std::vector<AccessPath> rank_paths(const TreeShape& table_shape, double predicate_rows, bool rowid_predicate,
+                                              bool reads_payload, const std::vector<IndexCandidate>& indexes);
+
+    static std::string describe(const AccessPath& path, const std::vector<IndexCandidate>& indexes);
+};
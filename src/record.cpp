@@ -2,108 +2,213 @@
 #include "utils.hpp"
 #include <stdexcept>
 #include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdio>
+#include <cmath>
 
-size_t Record::get_serial_type_size(int64_t serial_type) {
-    if (serial_type <= 11) {
-        switch (serial_type) {
-            case 0: return 0;
-            case 1: return 1;
-            case 2: return 2;
-            case 3: return 3;
-            case 4: return 4;
-            case 5: return 6;
-            case 6: return 8;
-            case 7: return 8;
-            case 8: return 0;
-            case 9: return 0;
-            case 10: case 11: return 0;
-        }
+int64_t Record::read_big_endian_int(std::span<const char> buffer, size_t offset, size_t size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(buffer[offset + i]);
+    }
+    // Integers are stored two's complement in the smallest width that fits, so sign-extend
+    if (size > 0 && size < 8 && (value >> (size * 8 - 1)) & 1) {
+        value |= ~uint64_t{0} << (size * 8);
     }
-    if (serial_type % 2 == 1) return (serial_type - 13) / 2;
-    return (serial_type - 12) / 2;
+    return static_cast<int64_t>(value);
 }
 
-int64_t Record::read_big_endian_int(const std::vector<char>& buffer, size_t offset, size_t size) {
-    int64_t value = 0;
-    for (size_t i = 0; i < size; ++i) {
-        // Sign extension logic omitted for brevity as generally positive rowids/values used here
-        value = (value << 8) | static_cast<unsigned char>(buffer[offset + i]);
+double Record::read_big_endian_double(std::span<const char> buffer, size_t offset) {
+    return std::bit_cast<double>(static_cast<uint64_t>(read_big_endian_int(buffer, offset, 8)));
+}
+
+std::string_view Record::format_real(double value, NumberBuffer& scratch) {
+    int len = std::snprintf(scratch.data(), scratch.size() - 2, "%.15g", value);
+    std::string_view text(scratch.data(), static_cast<size_t>(len));
+    // Whole numbers get ".0"; exponent, inf and nan forms are left alone
+    if (text.find_first_of(".en") == std::string_view::npos) {
+        scratch[len] = '.';
+        scratch[len + 1] = '0';
+        text = std::string_view(scratch.data(), static_cast<size_t>(len) + 2);
+    }
+    return text;
+}
+
+std::string Record::format_real(double value) {
+    NumberBuffer scratch;
+    return std::string(format_real(value, scratch));
+}
+
+std::vector<KeyProbe> Record::key_probes(std::string_view literal) {
+    std::vector<KeyProbe> probes;
+    if (literal.empty()) probes.push_back({ValueType::Null, 0, 0.0, {}});
+
+    const char* first = literal.data();
+    const char* last = literal.data() + literal.size();
+    int64_t integer = 0;
+    double real = 0.0;
+    if (auto [end, ec] = std::from_chars(first, last, integer); ec == std::errc() && end == last) {
+        probes.push_back({ValueType::Integer, integer, 0.0, {}});
+    } else if (auto [end, ec] = std::from_chars(first, last, real); ec == std::errc() && end == last && std::isfinite(real)) {
+        probes.push_back({ValueType::Real, 0, real, {}});
+    }
+
+    probes.push_back({ValueType::Text, 0, 0.0, literal});
+    if (literal.empty()) probes.push_back({ValueType::Blob, 0, 0.0, {}});
+    return probes;
+}
+
+static int storage_class_rank(ValueType type) {
+    switch (type) {
+        case ValueType::Null: return 0;
+        case ValueType::Integer:
+        case ValueType::Real: return 1;
+        case ValueType::Text: return 2;
+        case ValueType::Blob: return 3;
+    }
+    return 0;
+}
+
+template <typename T>
+static int three_way(T a, T b) {
+    return (a < b) ? -1 : (b < a) ? 1 : 0;
+}
+
+int Record::compare_column(std::span<const char> record_payload, int target_col_idx, const KeyProbe& probe) {
+    int64_t type = 0;
+    size_t body_cursor = 0;
+    ValueType key_type = ValueType::Null; // Columns missing from short records read as NULL
+    if (locate_column(record_payload, target_col_idx, type, body_cursor)) {
+        if ((type >= 1 && type <= 6) || type == 8 || type == 9) key_type = ValueType::Integer;
+        else if (type == 7) key_type = ValueType::Real;
+        else if (type >= 12) key_type = (type % 2 == 1) ? ValueType::Text : ValueType::Blob;
+    }
+
+    int rank = three_way(storage_class_rank(key_type), storage_class_rank(probe.type));
+    if (rank != 0 || key_type == ValueType::Null || key_type == ValueType::Blob) return rank;
+
+    if (key_type == ValueType::Text) {
+        std::string_view key(record_payload.data() + body_cursor, get_serial_type_size(type));
+        int c = key.compare(probe.text);
+        return (c < 0) ? -1 : (c > 0) ? 1 : 0;
+    }
+
+    // Numeric: mixed INTEGER/REAL compares go through long double, exact wherever it is 80-bit (x86)
+    long double key_value = 0;
+    if (key_type == ValueType::Real) {
+        key_value = read_big_endian_double(record_payload, body_cursor);
+    } else if (type == 8 || type == 9) {
+        key_value = type - 8;
+    } else if (probe.type == ValueType::Integer) {
+        return three_way(read_big_endian_int(record_payload, body_cursor, get_serial_type_size(type)), probe.integer);
+    } else {
+        key_value = static_cast<long double>(read_big_endian_int(record_payload, body_cursor, get_serial_type_size(type)));
     }
-    return value;
+    long double probe_value = (probe.type == ValueType::Integer) ? static_cast<long double>(probe.integer) : probe.real;
+    return three_way(key_value, probe_value);
 }
 
-std::string Record::parse_column_to_string(const std::vector<char>& record_payload, int target_col_idx) {
+bool Record::locate_column(std::span<const char> record_payload, int target_col_idx, int64_t& serial_type, size_t& body_offset) {
     size_t cursor = 0;
     auto [header_size, header_varint_len] = Utils::read_varint(record_payload, cursor);
     cursor += header_varint_len;
 
-    std::vector<int64_t> column_types;
-    size_t bytes_read_in_header = header_varint_len;
-    
-    while (bytes_read_in_header < header_size) {
+    // Header and body are walked together so no serial-type list is built
+    size_t body_cursor = header_size;
+    for (int i = 0; cursor < header_size; ++i) {
         auto [type, len] = Utils::read_varint(record_payload, cursor);
-        column_types.push_back(type);
         cursor += len;
-        bytes_read_in_header += len;
+        if (i == target_col_idx) {
+            serial_type = static_cast<int64_t>(type);
+            body_offset = body_cursor;
+            return true;
+        }
+        body_cursor += get_serial_type_size(type);
     }
+    return false;
+}
 
-    size_t body_cursor = header_size;
-    
-    for (int i = 0; i < column_types.size(); ++i) {
-        int64_t type = column_types[i];
-        size_t col_size = get_serial_type_size(type);
+std::string_view Record::column_text(std::span<const char> record_payload, int target_col_idx, NumberBuffer& scratch) {
+    int64_t type;
+    size_t body_cursor;
+    if (!locate_column(record_payload, target_col_idx, type, body_cursor)) return {};
+    size_t col_size = get_serial_type_size(type);
 
-        if (i == target_col_idx) {
-            // Integer types
-            if (type >= 1 && type <= 6) {
-                int64_t val = read_big_endian_int(record_payload, body_cursor, col_size);
-                return std::to_string(val);
-            }
-            if (type == 8) return "0";
-            if (type == 9) return "1";
-            
-            // String types
-            if (type >= 13 && (type % 2 == 1)) {
-                return std::string(record_payload.begin() + body_cursor, 
-                                   record_payload.begin() + body_cursor + col_size);
-            }
-            
-            // Null or Blob (returning empty for now)
-            return "";
-        }
-        body_cursor += col_size;
+    // Integer types
+    if (type >= 1 && type <= 6) {
+        int64_t val = read_big_endian_int(record_payload, body_cursor, col_size);
+        auto [end, ec] = std::to_chars(scratch.data(), scratch.data() + scratch.size(), val);
+        return std::string_view(scratch.data(), end - scratch.data());
     }
-    return "";
+    if (type == 7) return format_real(read_big_endian_double(record_payload, body_cursor), scratch);
+    if (type == 8) return "0";
+    if (type == 9) return "1";
+
+    // String types
+    if (type >= 13 && (type % 2 == 1)) {
+        return std::string_view(record_payload.data() + body_cursor, col_size);
+    }
+
+    // Null or Blob (returning empty for now)
+    return {};
 }
 
-std::string Record::parse_string_column(const std::vector<char>& record_payload, int target_col_idx) {
+std::string Record::parse_column_to_string(std::span<const char> record_payload, int target_col_idx) {
+    NumberBuffer scratch;
+    return std::string(column_text(record_payload, target_col_idx, scratch));
+}
+
+std::string Record::parse_string_column(std::span<const char> record_payload, int target_col_idx) {
     return parse_column_to_string(record_payload, target_col_idx);
 }
 
-int64_t Record::parse_int_column(const std::vector<char>& record_payload, int target_col_idx) {
+int64_t Record::parse_int_column(std::span<const char> record_payload, int target_col_idx) {
+    int64_t type;
+    size_t body_cursor;
+    if (!locate_column(record_payload, target_col_idx, type, body_cursor)) return -1;
+    if (type == 8) return 0;
+    if (type == 9) return 1;
+    if (type >= 1 && type <= 6) return read_big_endian_int(record_payload, body_cursor, get_serial_type_size(type));
+    return -1;
+}
+
+std::span<const char> Record::column_bytes(std::span<const char> record_payload, int target_col_idx) {
+    int64_t type;
+    size_t body_cursor;
+    if (!locate_column(record_payload, target_col_idx, type, body_cursor)) return {};
+    size_t col_size = get_serial_type_size(type);
+    if (type < 12 || body_cursor + col_size > record_payload.size()) return {};
+    return record_payload.subspan(body_cursor, col_size);
+}
+
+void Record::parse_values(std::span<const char> record_payload, std::vector<Value>& values) {
+    values.clear();
     size_t cursor = 0;
     auto [header_size, header_varint_len] = Utils::read_varint(record_payload, cursor);
     cursor += header_varint_len;
 
-    std::vector<int64_t> column_types;
-    size_t bytes_read_in_header = header_varint_len;
-    while (bytes_read_in_header < header_size) {
+    size_t body_cursor = header_size;
+    while (cursor < header_size) {
         auto [type, len] = Utils::read_varint(record_payload, cursor);
-        column_types.push_back(type);
         cursor += len;
-        bytes_read_in_header += len;
-    }
-    size_t body_cursor = header_size;
-    for (int i = 0; i < column_types.size(); ++i) {
-        int64_t type = column_types[i];
         size_t col_size = get_serial_type_size(type);
-        if (i == target_col_idx) {
-            if (type == 8) return 0;
-            if (type == 9) return 1;
-            if (type >= 1 && type <= 6) return read_big_endian_int(record_payload, body_cursor, col_size);
-            return -1; 
+
+        Value value;
+        if (type >= 1 && type <= 6) {
+            value.type = ValueType::Integer;
+            value.integer = read_big_endian_int(record_payload, body_cursor, col_size);
+        } else if (type == 7) {
+            value.type = ValueType::Real;
+            value.real = read_big_endian_double(record_payload, body_cursor);
+        } else if (type == 8 || type == 9) {
+            value.type = ValueType::Integer;
+            value.integer = type - 8;
+        } else if (type >= 12) {
+            value.type = (type % 2 == 1) ? ValueType::Text : ValueType::Blob;
+            value.bytes = std::string_view(record_payload.data() + body_cursor, col_size);
         }
+        values.push_back(value);
         body_cursor += col_size;
     }
-    return -1;
-}
\ No newline at end of file
+}
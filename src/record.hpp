@@ -2,16 +2,74 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <span>
+#include <array>
+#include <string_view>
+
+enum class ValueType { Null, Integer, Real, Text, Blob };
+
+// One decoded column. `bytes` points into the payload it was decoded from
+struct Value {
+    ValueType type = ValueType::Null;
+    int64_t integer = 0;
+    double real = 0.0;
+    std::string_view bytes;
+};
+
+// A WHERE literal taken as one storage class, for walking index B-trees in SQLite's key order.
+// `text` views the literal it was made from
+struct KeyProbe {
+    ValueType type = ValueType::Null;
+    int64_t integer = 0;
+    double real = 0.0;
+    std::string_view text;
+};
+
+// Room for the longest formatted integer or REAL
+using NumberBuffer = std::array<char, 32>;
 
 class Record {
 public:
-    static std::string parse_string_column(const std::vector<char>& record_payload, int target_col_idx);
-    static int64_t parse_int_column(const std::vector<char>& record_payload, int target_col_idx);
+    static std::string parse_string_column(std::span<const char> record_payload, int target_col_idx);
+    static int64_t parse_int_column(std::span<const char> record_payload, int target_col_idx);
     
     // New: generic parser that returns string representation of any column type
-    static std::string parse_column_to_string(const std::vector<char>& record_payload, int target_col_idx);
+    static std::string parse_column_to_string(std::span<const char> record_payload, int target_col_idx);
+
+    // Same text as parse_column_to_string without allocating: numbers are formatted into
+    // `scratch`, text is a view into the payload
+    static std::string_view column_text(std::span<const char> record_payload, int target_col_idx, NumberBuffer& scratch);
+
+    // Raw body bytes of a TEXT or BLOB column as a view into the payload (empty for other types)
+    static std::span<const char> column_bytes(std::span<const char> record_payload, int target_col_idx);
+
+    // Decodes every column of a record in one header walk; `values` is cleared and reused
+    static void parse_values(std::span<const char> record_payload, std::vector<Value>& values);
+
+    // Formats a REAL the way the sqlite3 shell does (15 significant digits, always a decimal point)
+    static std::string format_real(double value);
+    static std::string_view format_real(double value, NumberBuffer& scratch);
+
+    // Storage classes a literal can match as displayed text, in index order: numeric when it
+    // parses as a number, always TEXT, and NULL/BLOB for the empty literal (both display as "")
+    static std::vector<KeyProbe> key_probes(std::string_view literal);
+
+    // Orders a column against a probe the way SQLite orders BINARY-collated keys:
+    // NULL < INTEGER/REAL (compared numerically) < TEXT (memcmp) < BLOB. All NULLs compare equal,
+    // as do all BLOBs, so a NULL or BLOB probe spans its whole class
+    static int compare_column(std::span<const char> record_payload, int target_col_idx, const KeyProbe& probe);
+
+    // Body size in bytes of a column with the given serial type; inline since decoders call it per column
+    static size_t get_serial_type_size(int64_t serial_type) {
+        static constexpr uint8_t fixed_sizes[12] = {0, 1, 2, 3, 4, 6, 8, 8, 0, 0, 0, 0};
+        if (static_cast<uint64_t>(serial_type) < 12) return fixed_sizes[serial_type];
+        return static_cast<size_t>((serial_type - 12) / 2);
+    }
 
 private:
-    static size_t get_serial_type_size(int64_t serial_type);
-    static int64_t read_big_endian_int(const std::vector<char>& buffer, size_t offset, size_t size);
-};
\ No newline at end of file
+    static int64_t read_big_endian_int(std::span<const char> buffer, size_t offset, size_t size);
+    static double read_big_endian_double(std::span<const char> buffer, size_t offset);
+
+    // Walks the header up to `target_col_idx`; false if the record has fewer columns
+    static bool locate_column(std::span<const char> record_payload, int target_col_idx, int64_t& serial_type, size_t& body_offset);
+};
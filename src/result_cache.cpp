@@ -0,0 +1,208 @@
+#include "result_cache.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+static const char spill_magic[8] = {'S', 'Q', 'L', 'R', 'C', 'v', '1', '\0'};
+
+template <typename T>
+static void write_raw(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool read_raw(std::ifstream& in, T& value) {
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return in.gcount() == static_cast<std::streamsize>(sizeof(T));
+}
+
+static bool read_string(std::ifstream& in, std::string& value) {
+    uint64_t size = 0;
+    if (!read_raw(in, size)) return false;
+    value.resize(size);
+    in.read(value.data(), size);
+    return in.gcount() == static_cast<std::streamsize>(size);
+}
+
+ResultCache::ResultCache(ResultCacheOptions opts) : options(std::move(opts)) {
+    if (options.spill_dir.empty()) return;
+
+    std::error_code ec;
+    std::filesystem::create_directories(options.spill_dir, ec);
+    if (!ec && !std::filesystem::is_directory(options.spill_dir, ec)) {
+        ec = std::make_error_code(std::errc::not_a_directory);
+    }
+    if (ec) {
+        std::cerr << "warning: result cache disabled: cannot use " << options.spill_dir << ": " << ec.message()
+                  << std::endl;
+        usable = false;
+    }
+}
+
+std::optional<std::string> ResultCache::lookup(const std::string& key, const CacheStamp& stamp) {
+    if (!usable) return std::nullopt;
+
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        if (it->second->stamp == stamp) {
+            lru.splice(lru.begin(), lru, it->second);
+            return it->second->result;
+        }
+        // Stale: the file changed since this result was computed
+        erase_memory(key);
+        remove_spilled(key);
+        return std::nullopt;
+    }
+
+    if (options.spill_dir.empty()) return std::nullopt;
+
+    auto spilled = read_spilled(key);
+    if (!spilled) return std::nullopt;
+    if (!(spilled->stamp == stamp)) {
+        remove_spilled(key);
+        return std::nullopt;
+    }
+
+    // Touch the file so the disk cap evicts it after entries that haven't been read lately
+    std::error_code ec;
+    std::filesystem::last_write_time(spill_path(key), std::filesystem::file_time_type::clock::now(), ec);
+
+    std::string result = spilled->result;
+    insert_memory(std::move(*spilled));
+    return result;
+}
+
+void ResultCache::store(const std::string& key, const CacheStamp& stamp, std::string result) {
+    if (!usable) return;
+
+    erase_memory(key);
+    Entry entry{key, stamp, std::move(result)};
+    // Write-through so results survive the process and entries evicted from memory stay reachable
+    if (!options.spill_dir.empty()) {
+        write_spilled(entry);
+        trim_spill_dir();
+    }
+    insert_memory(std::move(entry));
+}
+
+void ResultCache::insert_memory(Entry entry) {
+    size_t size = entry.key.size() + entry.result.size();
+    if (size > options.max_memory_bytes) return; // Too large to hold; served from disk if spilled
+
+    evict_to(options.max_memory_bytes - size);
+    memory_bytes += size;
+    std::string key = entry.key;
+    lru.push_front(std::move(entry));
+    entries[key] = lru.begin();
+}
+
+void ResultCache::erase_memory(const std::string& key) {
+    auto it = entries.find(key);
+    if (it == entries.end()) return;
+    memory_bytes -= it->second->key.size() + it->second->result.size();
+    lru.erase(it->second);
+    entries.erase(it);
+}
+
+void ResultCache::evict_to(size_t limit) {
+    while (memory_bytes > limit && !lru.empty()) {
+        erase_memory(lru.back().key);
+    }
+}
+
+std::string ResultCache::spill_path(const std::string& key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016zx.qrc", std::hash<std::string>{}(key));
+    return (std::filesystem::path(options.spill_dir) / name).string();
+}
+
+std::optional<ResultCache::Entry> ResultCache::read_spilled(const std::string& key) const {
+    std::ifstream in(spill_path(key), std::ios::binary);
+    if (!in) return std::nullopt;
+
+    char magic[sizeof(spill_magic)];
+    in.read(magic, sizeof(magic));
+    if (in.gcount() != sizeof(magic) || !std::equal(magic, magic + sizeof(magic), spill_magic)) {
+        return std::nullopt;
+    }
+
+    Entry entry;
+    if (!read_string(in, entry.key) || entry.key != key) return std::nullopt; // Hash collision
+    if (!read_raw(in, entry.stamp.change_counter) || !read_raw(in, entry.stamp.wal_size) ||
+        !read_raw(in, entry.stamp.wal_checkpoint) || !read_raw(in, entry.stamp.wal_salt1) ||
+        !read_raw(in, entry.stamp.wal_salt2)) {
+        return std::nullopt;
+    }
+    if (!read_string(in, entry.result)) return std::nullopt;
+    return entry;
+}
+
+void ResultCache::write_spilled(const Entry& entry) const {
+    if (entry.key.size() + entry.result.size() > options.max_disk_bytes) return; // Would be evicted at once
+
+    std::string path = spill_path(entry.key);
+    std::string tmp_path = path + ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) return; // The cache is best-effort; a failed spill only costs a rescan
+        out.write(spill_magic, sizeof(spill_magic));
+        write_raw(out, static_cast<uint64_t>(entry.key.size()));
+        out.write(entry.key.data(), entry.key.size());
+        write_raw(out, entry.stamp.change_counter);
+        write_raw(out, entry.stamp.wal_size);
+        write_raw(out, entry.stamp.wal_checkpoint);
+        write_raw(out, entry.stamp.wal_salt1);
+        write_raw(out, entry.stamp.wal_salt2);
+        write_raw(out, static_cast<uint64_t>(entry.result.size()));
+        out.write(entry.result.data(), entry.result.size());
+        if (!out) {
+            out.close();
+            std::filesystem::remove(tmp_path, ec);
+            return;
+        }
+    }
+    // Rename so concurrent readers never see a half-written file
+    std::filesystem::rename(tmp_path, path, ec);
+}
+
+void ResultCache::remove_spilled(const std::string& key) const {
+    if (options.spill_dir.empty()) return;
+    std::error_code ec;
+    std::filesystem::remove(spill_path(key), ec);
+}
+
+void ResultCache::trim_spill_dir() const {
+    struct SpillFile {
+        std::filesystem::path path;
+        std::filesystem::file_time_type modified;
+        uintmax_t size;
+    };
+
+    // Other processes share the directory, so the total is re-read rather than tracked in memory
+    std::vector<SpillFile> files;
+    uintmax_t total = 0;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(options.spill_dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".qrc") continue;
+        std::error_code stat_ec;
+        uintmax_t size = it->file_size(stat_ec);
+        auto modified = it->last_write_time(stat_ec);
+        if (stat_ec) continue; // Removed by another process mid-scan
+        files.push_back({it->path(), modified, size});
+        total += size;
+    }
+    if (total <= options.max_disk_bytes) return;
+
+    std::sort(files.begin(), files.end(),
+              [](const SpillFile& a, const SpillFile& b) { return a.modified < b.modified; });
+    for (const auto& file : files) {
+        if (total <= options.max_disk_bytes) break;
+        std::filesystem::remove(file.path, ec);
+        total -= file.size;
+    }
+}
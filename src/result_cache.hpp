@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+// Identifies the database state a cached result was computed against.
+// The change counter (header offset 24) moves on every rollback-journal commit;
+// in WAL mode it doesn't, so the WAL header and size are tracked too.
+struct CacheStamp {
+    uint32_t change_counter = 0;
+    uint64_t wal_size = 0;
+    uint32_t wal_checkpoint = 0;
+    uint32_t wal_salt1 = 0;
+    uint32_t wal_salt2 = 0;
+
+    bool operator==(const CacheStamp&) const = default;
+};
+
+struct ResultCacheOptions {
+    size_t max_memory_bytes = 64 * 1024 * 1024;
+    size_t max_disk_bytes = 256 * 1024 * 1024; // Spill files past this are removed, least recently used first
+    std::string spill_dir; // Empty keeps the cache memory-only
+};
+
+class ResultCache {
+private:
+    struct Entry {
+        std::string key;
+        CacheStamp stamp;
+        std::string result;
+    };
+
+    ResultCacheOptions options;
+    std::list<Entry> lru; // Front is most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> entries;
+    size_t memory_bytes = 0;
+    bool usable = true; // Cleared when the spill directory can't be created
+
+    void insert_memory(Entry entry);
+    void erase_memory(const std::string& key);
+    void evict_to(size_t limit);
+
+    std::string spill_path(const std::string& key) const;
+    std::optional<Entry> read_spilled(const std::string& key) const;
+    void write_spilled(const Entry& entry) const;
+    void remove_spilled(const std::string& key) const;
+    void trim_spill_dir() const;
+
+public:
+    // An unusable spill directory disables the cache with a warning on stderr rather than failing
+    explicit ResultCache(ResultCacheOptions opts);
+
+    bool enabled() const { return usable; }
+
+    // Returns the cached output for `key` if it was stored under the same stamp
+    std::optional<std::string> lookup(const std::string& key, const CacheStamp& stamp);
+    void store(const std::string& key, const CacheStamp& stamp, std::string result);
+};
@@ -1,76 +1,41 @@
 #include "schema.hpp"
-#include "btree.hpp"
 #include "record.hpp"
-#include "utils.hpp"
 #include <sstream>
 #include <algorithm>
+#include <map>
 
-static size_t page_1_ptr_start = 100 + 8;
+SchemaObject Schema::parse_entry(std::span<const char> record_payload) {
+    return {Record::parse_string_column(record_payload, 0), Record::parse_string_column(record_payload, 1),
+            Record::parse_string_column(record_payload, 2), Record::parse_int_column(record_payload, 3),
+            Record::parse_string_column(record_payload, 4)};
+}
 
-std::vector<std::string> Schema::get_table_names(const std::vector<char>& page_1_data) {
+// The CREATE TABLE row for a table, or nullptr
+static const SchemaObject* find_table(const std::vector<SchemaObject>& schema, const std::string& table_name) {
+    for (const auto& entry : schema) {
+        if (entry.type == "table" && entry.name == table_name) return &entry;
+    }
+    return nullptr;
+}
+
+std::vector<std::string> Schema::get_table_names(const std::vector<SchemaObject>& schema) {
     std::vector<std::string> tables;
-    size_t page_header_offset = 100;
-    uint16_t cell_count = BTree::parse_cell_count(page_1_data, page_header_offset);
-    auto cell_pointers = BTree::parse_cell_pointers(page_1_data, page_1_ptr_start, cell_count);
-    
-    for (uint16_t offset : cell_pointers) {
-        size_t cursor = offset;
-        auto [payload_size, s1] = Utils::read_varint(page_1_data, cursor);
-        cursor += s1;
-        auto [row_id, s2] = Utils::read_varint(page_1_data, cursor);
-        cursor += s2;
-        std::vector<char> record_payload(page_1_data.begin() + cursor, 
-                                         page_1_data.begin() + cursor + payload_size);
-        std::string tbl_name = Record::parse_string_column(record_payload, 2);
-        std::string type = Record::parse_string_column(record_payload, 0);
-        if (type == "table" && tbl_name != "sqlite_sequence") {
-            tables.push_back(tbl_name);
+    for (const auto& entry : schema) {
+        if (entry.type == "table" && entry.tbl_name != "sqlite_sequence") {
+            tables.push_back(entry.tbl_name);
         }
     }
     return tables;
 }
 
-int Schema::get_root_page_number(const std::vector<char>& page_1_data, const std::string& target_table) {
-    size_t page_header_offset = 100;
-    uint16_t cell_count = BTree::parse_cell_count(page_1_data, page_header_offset);
-    auto cell_pointers = BTree::parse_cell_pointers(page_1_data, page_1_ptr_start, cell_count);
-    
-    for (uint16_t offset : cell_pointers) {
-        size_t cursor = offset;
-        auto [payload_size, s1] = Utils::read_varint(page_1_data, cursor);
-        cursor += s1;
-        auto [row_id, s2] = Utils::read_varint(page_1_data, cursor);
-        cursor += s2;
-        std::vector<char> record_payload(page_1_data.begin() + cursor, 
-                                         page_1_data.begin() + cursor + payload_size);
-        std::string tbl_name = Record::parse_string_column(record_payload, 2);
-        if (tbl_name == target_table) {
-            return static_cast<int>(Record::parse_int_column(record_payload, 3));
-        }
-    }
-    return -1;
+int64_t Schema::get_root_page_number(const std::vector<SchemaObject>& schema, const std::string& target_table) {
+    const SchemaObject* table = find_table(schema, target_table);
+    return table ? table->root_page : -1;
 }
 
-ColumnInfo Schema::get_column_info(const std::vector<char>& page_1_data, const std::string& table_name, const std::string& column_name) {
-    std::string create_sql = "";
-    size_t page_header_offset = 100;
-    uint16_t cell_count = BTree::parse_cell_count(page_1_data, page_header_offset);
-    auto cell_pointers = BTree::parse_cell_pointers(page_1_data, page_1_ptr_start, cell_count);
-    
-    for (uint16_t offset : cell_pointers) {
-        size_t cursor = offset;
-        auto [payload_size, s1] = Utils::read_varint(page_1_data, cursor);
-        cursor += s1;
-        auto [row_id, s2] = Utils::read_varint(page_1_data, cursor);
-        cursor += s2;
-        std::vector<char> record_payload(page_1_data.begin() + cursor, 
-                                         page_1_data.begin() + cursor + payload_size);
-        std::string tbl_name = Record::parse_string_column(record_payload, 2);
-        if (tbl_name == table_name) {
-            create_sql = Record::parse_string_column(record_payload, 4);
-            break;
-        }
-    }
+ColumnInfo Schema::get_column_info(const std::vector<SchemaObject>& schema, const std::string& table_name, const std::string& column_name) {
+    const SchemaObject* table = find_table(schema, table_name);
+    std::string create_sql = table ? table->sql : "";
     
     if (create_sql.empty()) return {-1, false};
 
@@ -104,31 +69,113 @@ ColumnInfo Schema::get_column_info(const std::vector<char>& page_1_data, const s
     return {-1, false};
 }
 
-int Schema::get_column_index(const std::vector<char>& page_1_data, const std::string& table_name, const std::string& column_name) {
-    return get_column_info(page_1_data, table_name, column_name).index;
+int Schema::get_column_index(const std::vector<SchemaObject>& schema, const std::string& table_name, const std::string& column_name) {
+    return get_column_info(schema, table_name, column_name).index;
 }
 
-int Schema::get_index_root_page(const std::vector<char>& page_1_data, const std::string& index_name) {
-    size_t page_header_offset = 100;
-    uint16_t cell_count = BTree::parse_cell_count(page_1_data, page_header_offset);
-    auto cell_pointers = BTree::parse_cell_pointers(page_1_data, page_1_ptr_start, cell_count);
-    
-    for (uint16_t offset : cell_pointers) {
-        size_t cursor = offset;
-        auto [payload_size, s1] = Utils::read_varint(page_1_data, cursor);
-        cursor += s1;
-        auto [row_id, s2] = Utils::read_varint(page_1_data, cursor);
-        cursor += s2;
-        std::vector<char> record_payload(page_1_data.begin() + cursor, 
-                                         page_1_data.begin() + cursor + payload_size);
-        
-        // sqlite_schema: type(0), name(1), tbl_name(2), rootpage(3), sql(4)
-        std::string name = Record::parse_string_column(record_payload, 1);
-        std::string type = Record::parse_string_column(record_payload, 0);
-        
-        if (type == "index" && name == index_name) {
-             return static_cast<int>(Record::parse_int_column(record_payload, 3)); // rootpage
-        }
+int64_t Schema::get_index_root_page(const std::vector<SchemaObject>& schema, const std::string& index_name) {
+    for (const auto& entry : schema) {
+        if (entry.type == "index" && entry.name == index_name) return entry.root_page;
     }
     return -1;
-}
\ No newline at end of file
+}
+
+// Upper-cased whitespace-separated words of a column definition
+static std::vector<std::string> upper_words(const std::string& text) {
+    std::vector<std::string> words;
+    std::stringstream ss(text);
+    std::string word;
+    while (ss >> word) {
+        std::transform(word.begin(), word.end(), word.begin(), ::toupper);
+        words.push_back(word);
+    }
+    return words;
+}
+
+// True when the words carry a COLLATE clause naming anything but BINARY
+static bool has_custom_collation(const std::vector<std::string>& words) {
+    for (size_t i = 0; i + 1 < words.size(); ++i) {
+        if (words[i] == "COLLATE" && words[i + 1] != "BINARY") return true;
+    }
+    return false;
+}
+
+static std::string strip_quotes(std::string name) {
+    if (name.size() >= 2 && (name.front() == '"' || name.front() == '`' || name.front() == '\'' || name.front() == '[')) {
+        name = name.substr(1, name.size() - 2);
+    }
+    return name;
+}
+
+std::vector<IndexDef> Schema::get_indexes(const std::vector<SchemaObject>& schema, const std::string& table_name) {
+    std::vector<IndexDef> indexes;
+
+    // Indexes inherit a column's declared collation, so the table definition is needed too
+    std::map<std::string, std::vector<std::string>> table_columns;
+    if (const SchemaObject* table = find_table(schema, table_name)) {
+        const std::string& create_sql = table->sql;
+        size_t start = create_sql.find('(');
+        size_t end = create_sql.rfind(')');
+        if (start != std::string::npos && end != std::string::npos && end > start) {
+            std::stringstream ss(create_sql.substr(start + 1, end - start - 1));
+            std::string segment;
+            while (std::getline(ss, segment, ',')) {
+                auto words = upper_words(segment);
+                if (words.empty()) continue;
+                size_t first = segment.find_first_not_of(" \t\n\r");
+                std::string col_name = segment.substr(first, segment.find_first_of(" \t\n\r", first) - first);
+                table_columns[strip_quotes(col_name)] = words;
+            }
+        }
+    }
+
+    for (const auto& entry : schema) {
+        if (entry.type != "index" || entry.tbl_name != table_name) continue;
+
+        // CREATE INDEX name ON table (col [COLLATE x] [ASC|DESC], ...) [WHERE ...]
+        const std::string& create_sql = entry.sql;
+        size_t start = create_sql.find('(');
+        size_t end = create_sql.find(')', start == std::string::npos ? 0 : start);
+        if (start == std::string::npos || end == std::string::npos) continue;
+
+        // Index scans assume a full index of plain columns in ascending BINARY order. Partial
+        // indexes (anything after the column list), expressions (a nested '('), DESC and
+        // non-BINARY collations are left out rather than risk wrong results
+        std::string column_list = create_sql.substr(start + 1, end - start - 1);
+        if (create_sql.find_first_not_of(" \t\n\r;", end + 1) != std::string::npos) continue;
+        if (column_list.find('(') != std::string::npos) continue;
+
+        IndexDef def;
+        def.name = entry.name;
+        def.root_page = entry.root_page;
+
+        bool supported = true;
+        std::stringstream ss(column_list);
+        std::string segment;
+        while (supported && std::getline(ss, segment, ',')) {
+            size_t first = segment.find_first_not_of(" \t\n\r");
+            if (first == std::string::npos) continue;
+            std::string col_name = strip_quotes(segment.substr(first, segment.find_first_of(" \t\n\r", first) - first));
+
+            auto words = upper_words(segment);
+            bool descending = std::find(words.begin(), words.end(), "DESC") != words.end();
+            auto declared = table_columns.find(col_name);
+            if (descending || has_custom_collation(words) || declared == table_columns.end() ||
+                has_custom_collation(declared->second)) {
+                supported = false;
+            }
+            def.columns.push_back(col_name);
+        }
+        if (supported && !def.columns.empty()) indexes.push_back(def);
+    }
+    return indexes;
+}
+
+std::vector<SchemaObject> Schema::get_btree_objects(const std::vector<SchemaObject>& schema) {
+    // Views and triggers have root page 0 and no B-tree
+    std::vector<SchemaObject> objects;
+    for (const auto& object : schema) {
+        if (object.root_page > 0) objects.push_back(object);
+    }
+    return objects;
+}
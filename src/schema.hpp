@@ -1,19 +1,47 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <span>
+#include <cstdint>
 
 struct ColumnInfo {
     int index;
     bool is_primary_key;
 };
 
+struct IndexDef {
+    std::string name;
+    int64_t root_page;
+    std::vector<std::string> columns; // Key columns in index order; the rowid follows them in each entry
+};
+
+// One sqlite_schema row: type(0), name(1), tbl_name(2), rootpage(3), sql(4).
+// Views and triggers have root page 0; every other row owns a B-tree
+struct SchemaObject {
+    std::string type;     // "table", "index", "view" or "trigger"
+    std::string name;
+    std::string tbl_name;
+    int64_t root_page;
+    std::string sql;
+};
+
+// Lookups over the decoded sqlite_schema rows. The rows come from a walk of the whole page-1
+// B-tree, so catalogs that span several pages or spill to overflow pages are read in full
 class Schema {
 public:
-    static std::vector<std::string> get_table_names(const std::vector<char>& page_1_data);
-    static int get_root_page_number(const std::vector<char>& page_1_data, const std::string& target_table);
-    static ColumnInfo get_column_info(const std::vector<char>& page_1_data, const std::string& table_name, const std::string& column_name);
-    static int get_column_index(const std::vector<char>& page_1_data, const std::string& table_name, const std::string& column_name);
+    static SchemaObject parse_entry(std::span<const char> record_payload);
+
+    static std::vector<std::string> get_table_names(const std::vector<SchemaObject>& schema);
+    static int64_t get_root_page_number(const std::vector<SchemaObject>& schema, const std::string& target_table);
+    static ColumnInfo get_column_info(const std::vector<SchemaObject>& schema, const std::string& table_name, const std::string& column_name);
+    static int get_column_index(const std::vector<SchemaObject>& schema, const std::string& table_name, const std::string& column_name);
     
     // New: Find root page of an index by name
-    static int get_index_root_page(const std::vector<char>& page_1_data, const std::string& index_name);
-};
\ No newline at end of file
+    static int64_t get_index_root_page(const std::vector<SchemaObject>& schema, const std::string& index_name);
+
+    // All indexes on a table that have a CREATE INDEX statement (auto-indexes carry no SQL and are skipped)
+    static std::vector<IndexDef> get_indexes(const std::vector<SchemaObject>& schema, const std::string& table_name);
+
+    // Every table and index B-tree in schema order, including auto-indexes and internal tables
+    static std::vector<SchemaObject> get_btree_objects(const std::vector<SchemaObject>& schema);
+};
@@ -3,6 +3,7 @@
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include <cctype>
 
 std::optional<SelectQuery> SQL::parse_select(const std::string& query) {
     std::string q_upper = query;
@@ -74,5 +75,26 @@ std::optional<SelectQuery> SQL::parse_select(const std::string& query) {
 
     if (columns.empty()) return std::nullopt;
 
-    return SelectQuery{columns, table_name, where_col, where_val};
-}
\ No newline at end of file
+    size_t lead = q_upper.find_first_not_of(" \t\n\r");
+    bool explain = lead != std::string::npos && q_upper.compare(lead, 7, "EXPLAIN") == 0;
+
+    return SelectQuery{columns, table_name, where_col, where_val, explain};
+}
+
+std::string SQL::cache_key(const SelectQuery& query) {
+    // Execution reads nothing but these fields, so equal keys always mean equal results.
+    // Every field is length-prefixed so values containing separators can't collide
+    std::string key;
+    auto append = [&key](const std::string& field) {
+        key += std::to_string(field.size());
+        key += ':';
+        key += field;
+    };
+    key += query.explain ? 'E' : 'S';
+    key += std::to_string(query.columns.size());
+    for (const auto& column : query.columns) append(column);
+    append(query.table);
+    append(query.where_column);
+    append(query.where_value);
+    return key;
+}
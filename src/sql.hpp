@@ -8,9 +8,14 @@ struct SelectQuery {
     std::string table;
     std::string where_column;
     std::string where_value;
+    bool explain = false; // EXPLAIN [QUERY PLAN] prefix: report the plan instead of running it
 };
 
 class SQL {
 public:
     static std::optional<SelectQuery> parse_select(const std::string& query);
+
+    // Cache key built from the parsed fields, so formatting differences share an entry but
+    // values that parse differently (e.g. unquoted literals with inner spaces) never do
+    static std::string cache_key(const SelectQuery& query);
 };
\ No newline at end of file
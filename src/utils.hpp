@@ -1,12 +1,13 @@
 #pragma once
 #include <cstdint>
 #include <vector>
+#include <span>
 #include <stdexcept>
 #include <utility>
 
 class Utils {
 public:
-    static uint16_t parse_u16(const std::vector<char>& buffer, size_t offset) {
+    static uint16_t parse_u16(std::span<const char> buffer, size_t offset) {
         if (offset + 2 > buffer.size()) {
             throw std::out_of_range("Buffer overflow reading u16");
         }
@@ -14,7 +15,7 @@ public:
         return (static_cast<uint16_t>(bytes[0]) << 8) | bytes[1];
     }
 
-    static uint32_t parse_u32(const std::vector<char>& buffer, size_t offset) {
+    static uint32_t parse_u32(std::span<const char> buffer, size_t offset) {
         if (offset + 4 > buffer.size()) {
             throw std::out_of_range("Buffer overflow reading u32");
         }
@@ -25,7 +26,7 @@ public:
                bytes[3];
     }
 
-    static std::pair<uint64_t, int> read_varint(const std::vector<char>& buffer, size_t offset) {
+    static std::pair<uint64_t, int> read_varint(std::span<const char> buffer, size_t offset) {
         uint64_t value = 0;
         int bytes_read = 0;
         